@@ -0,0 +1,36 @@
+#include "CameraUniforms.h"
+#include <glm/gtc/type_ptr.hpp>
+
+void CameraUniforms::Initialize()
+{
+	glGenBuffers(1, &m_uniformBuffer);
+	glBindBuffer(GL_UNIFORM_BUFFER, m_uniformBuffer);
+	glBufferData(GL_UNIFORM_BUFFER, sizeof(glm::mat4), nullptr, GL_DYNAMIC_DRAW); // a std140 mat4 has no padding
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+void CameraUniforms::Update(const glm::mat4& viewProjection)
+{
+	glBindBuffer(GL_UNIFORM_BUFFER, m_uniformBuffer);
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(glm::mat4), glm::value_ptr(viewProjection));
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	Bind(); // another camera may have been bound meanwhile
+}
+
+void CameraUniforms::Bind() const
+{
+	glBindBufferBase(GL_UNIFORM_BUFFER, BINDING_POINT, m_uniformBuffer);
+}
+
+void CameraUniforms::ClearResources()
+{
+	glDeleteBuffers(1, &m_uniformBuffer);
+	m_uniformBuffer = 0;
+}
+
+void CameraUniforms::BindBlock(GLuint shaderProgram)
+{
+	GLuint blockIndex = glGetUniformBlockIndex(shaderProgram, "Camera");
+	if (blockIndex != GL_INVALID_INDEX) // unused blocks are removed by the linker
+		glUniformBlockBinding(shaderProgram, blockIndex, BINDING_POINT);
+}
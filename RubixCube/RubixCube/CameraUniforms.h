@@ -0,0 +1,22 @@
+#pragma once
+#include <glm/mat4x4.hpp>
+#include <GL/glew.h>
+
+// The camera of a frame in a uniform buffer that all shader programs share, uploaded once per frame instead of being
+// multiplied into the transformation of every draw call. Shaders declare it as
+//     layout(std140) uniform Camera { mat4 viewProjection; };
+class CameraUniforms
+{
+public:
+	static const GLuint BINDING_POINT = 0;
+
+	void Initialize();
+	void Update(const glm::mat4& viewProjection); // before the first draw call of the frame
+	void Bind() const; // makes this camera current again without uploading anything
+	void ClearResources();
+
+	static void BindBlock(GLuint shaderProgram); // connects the Camera block of a program to BINDING_POINT
+
+private:
+	GLuint m_uniformBuffer = 0;
+};
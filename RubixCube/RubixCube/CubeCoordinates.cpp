@@ -0,0 +1,284 @@
+#include "CubeCoordinates.h"
+
+namespace
+{
+	const int SLICE_EDGE = 8; // FR, FL, BL and BR are the pieces 8..11
+
+	int Binomial(int n, int k)
+	{
+		if (k < 0 || k > n)
+			return 0;
+		int result = 1;
+		for (int i = 1; i <= k; ++i)
+			result = result * (n - k + i) / i;
+		return result;
+	}
+
+	int Parity(const int* permutation, int count)
+	{
+		int parity = 0;
+		for (int i = 0; i < count; ++i)
+			for (int j = i + 1; j < count; ++j)
+				if (permutation[i] > permutation[j])
+					parity ^= 1;
+		return parity;
+	}
+}
+
+int CubeCoordinates::GetTwist(const CubeState& cube)
+{
+	int twist = 0;
+	for (int slot = 0; slot < CubeState::CORNER_COUNT - 1; ++slot) // the last twist follows from the others
+		twist = 3 * twist + cube.GetCornerTwist(slot);
+	return twist;
+}
+
+void CubeCoordinates::SetTwist(CubeState& cube, int twist)
+{
+	int sum = 0;
+	for (int slot = CubeState::CORNER_COUNT - 2; slot >= 0; --slot)
+	{
+		cube.SetCorner(slot, cube.GetCornerPiece(slot), twist % 3);
+		sum += twist % 3;
+		twist /= 3;
+	}
+	int last = CubeState::CORNER_COUNT - 1;
+	cube.SetCorner(last, cube.GetCornerPiece(last), (3 - sum % 3) % 3);
+}
+
+int CubeCoordinates::GetFlip(const CubeState& cube)
+{
+	int flip = 0;
+	for (int slot = 0; slot < CubeState::EDGE_COUNT - 1; ++slot)
+		flip = 2 * flip + cube.GetEdgeFlip(slot);
+	return flip;
+}
+
+void CubeCoordinates::SetFlip(CubeState& cube, int flip)
+{
+	int sum = 0;
+	for (int slot = CubeState::EDGE_COUNT - 2; slot >= 0; --slot)
+	{
+		cube.SetEdge(slot, cube.GetEdgePiece(slot), flip & 1);
+		sum += flip & 1;
+		flip >>= 1;
+	}
+	int last = CubeState::EDGE_COUNT - 1;
+	cube.SetEdge(last, cube.GetEdgePiece(last), sum & 1);
+}
+
+int CubeCoordinates::GetSlice(const CubeState& cube)
+{
+	// combinatorial number of the occupied slots, counted from BR downwards so that the solved cube is 0
+	int slice = 0;
+	int found = 0;
+	for (int slot = CubeState::EDGE_COUNT - 1; slot >= 0; --slot)
+	{
+		if (cube.GetEdgePiece(slot) >= SLICE_EDGE)
+		{
+			++found;
+			slice += Binomial(CubeState::EDGE_COUNT - 1 - slot, found);
+		}
+	}
+	return slice;
+}
+
+void CubeCoordinates::SetSlice(CubeState& cube, int slice)
+{
+	bool occupied[CubeState::EDGE_COUNT] = {};
+	for (int found = 4; found > 0; --found)
+	{
+		int j = found - 1;
+		while (Binomial(j + 1, found) <= slice)
+			++j;
+		slice -= Binomial(j, found);
+		occupied[CubeState::EDGE_COUNT - 1 - j] = true;
+	}
+
+	int sliceEdge = SLICE_EDGE;
+	int otherEdge = 0;
+	for (int slot = 0; slot < CubeState::EDGE_COUNT; ++slot)
+		cube.SetEdge(slot, occupied[slot] ? sliceEdge++ : otherEdge++, cube.GetEdgeFlip(slot));
+}
+
+int CubeCoordinates::GetCornerPerm(const CubeState& cube)
+{
+	int permutation[CubeState::CORNER_COUNT];
+	for (int slot = 0; slot < CubeState::CORNER_COUNT; ++slot)
+		permutation[slot] = cube.GetCornerPiece(slot);
+	return RankPermutation(permutation, CubeState::CORNER_COUNT);
+}
+
+void CubeCoordinates::SetCornerPerm(CubeState& cube, int perm)
+{
+	int permutation[CubeState::CORNER_COUNT];
+	UnrankPermutation(perm, permutation, CubeState::CORNER_COUNT);
+	for (int slot = 0; slot < CubeState::CORNER_COUNT; ++slot)
+		cube.SetCorner(slot, permutation[slot], cube.GetCornerTwist(slot));
+}
+
+int CubeCoordinates::GetEdge8Perm(const CubeState& cube)
+{
+	int permutation[8];
+	for (int slot = 0; slot < 8; ++slot)
+		permutation[slot] = cube.GetEdgePiece(slot);
+	return RankPermutation(permutation, 8);
+}
+
+void CubeCoordinates::SetEdge8Perm(CubeState& cube, int perm)
+{
+	int permutation[8];
+	UnrankPermutation(perm, permutation, 8);
+	for (int slot = 0; slot < 8; ++slot)
+		cube.SetEdge(slot, permutation[slot], cube.GetEdgeFlip(slot));
+}
+
+int CubeCoordinates::GetSlicePerm(const CubeState& cube)
+{
+	int permutation[4];
+	for (int i = 0; i < 4; ++i)
+		permutation[i] = cube.GetEdgePiece(SLICE_EDGE + i) - SLICE_EDGE;
+	return RankPermutation(permutation, 4);
+}
+
+void CubeCoordinates::SetSlicePerm(CubeState& cube, int perm)
+{
+	int permutation[4];
+	UnrankPermutation(perm, permutation, 4);
+	for (int i = 0; i < 4; ++i)
+		cube.SetEdge(SLICE_EDGE + i, SLICE_EDGE + permutation[i], cube.GetEdgeFlip(SLICE_EDGE + i));
+}
+
+int CubeCoordinates::GetEdge6Position(const CubeState& cube, int firstPiece)
+{
+	int combination = 0;
+	int permutation[6];
+	int found = 0;
+	for (int i = 0; i < CubeState::EDGE_COUNT; ++i)
+	{
+		int piece = cube.GetEdgePiece((firstPiece + i) % CubeState::EDGE_COUNT) - firstPiece;
+		if (piece < 0)
+			piece += CubeState::EDGE_COUNT;
+		if (piece < 6)
+		{
+			permutation[found++] = piece;
+			combination += Binomial(i, found);
+		}
+	}
+	return combination * 720 + RankPermutation(permutation, 6);
+}
+
+void CubeCoordinates::SetEdge6Position(CubeState& cube, int firstPiece, int position)
+{
+	int combination = position / 720;
+	int permutation[6];
+	UnrankPermutation(position % 720, permutation, 6);
+
+	bool occupied[CubeState::EDGE_COUNT] = {};
+	for (int found = 6; found > 0; --found)
+	{
+		int i = found - 1;
+		while (Binomial(i + 1, found) <= combination)
+			++i;
+		combination -= Binomial(i, found);
+		occupied[i] = true;
+	}
+
+	int tracked = 0;
+	int other = 6;
+	for (int i = 0; i < CubeState::EDGE_COUNT; ++i)
+	{
+		int piece = occupied[i] ? permutation[tracked++] : other++;
+		cube.SetEdge((firstPiece + i) % CubeState::EDGE_COUNT, (firstPiece + piece) % CubeState::EDGE_COUNT, 0);
+	}
+}
+
+int CubeCoordinates::GetEdge6Flip(const CubeState& cube, int firstPiece)
+{
+	int flip = 0;
+	for (int i = 0; i < CubeState::EDGE_COUNT; ++i)
+	{
+		int slot = (firstPiece + i) % CubeState::EDGE_COUNT;
+		int piece = (cube.GetEdgePiece(slot) - firstPiece + CubeState::EDGE_COUNT) % CubeState::EDGE_COUNT;
+		if (piece < 6)
+			flip = 2 * flip + cube.GetEdgeFlip(slot);
+	}
+	return flip;
+}
+
+void CubeCoordinates::SetEdge6Flip(CubeState& cube, int firstPiece, int flip)
+{
+	for (int i = CubeState::EDGE_COUNT - 1; i >= 0; --i)
+	{
+		int slot = (firstPiece + i) % CubeState::EDGE_COUNT;
+		int piece = (cube.GetEdgePiece(slot) - firstPiece + CubeState::EDGE_COUNT) % CubeState::EDGE_COUNT;
+		if (piece < 6)
+		{
+			cube.SetEdge(slot, cube.GetEdgePiece(slot), flip & 1);
+			flip >>= 1;
+		}
+	}
+}
+
+int CubeCoordinates::RankPermutation(const int* permutation, int count)
+{
+	int rank = 0;
+	for (int i = 0; i < count; ++i)
+	{
+		int smaller = 0; // entries right of i that are smaller than permutation[i]
+		for (int j = i + 1; j < count; ++j)
+			if (permutation[j] < permutation[i])
+				++smaller;
+		rank = rank * (count - i) + smaller;
+	}
+	return rank;
+}
+
+void CubeCoordinates::UnrankPermutation(int rank, int* permutation, int count)
+{
+	int digits[12];
+	for (int i = count - 1; i >= 0; --i)
+	{
+		digits[i] = rank % (count - i);
+		rank /= count - i;
+	}
+
+	bool used[12] = {};
+	for (int i = 0; i < count; ++i)
+	{
+		int skip = digits[i];
+		int value = 0;
+		while (used[value] || skip > 0)
+		{
+			if (!used[value])
+				--skip;
+			++value;
+		}
+		used[value] = true;
+		permutation[i] = value;
+	}
+}
+
+bool CubeCoordinates::IsSolvable(const CubeState& cube)
+{
+	int corners[CubeState::CORNER_COUNT];
+	int edges[CubeState::EDGE_COUNT];
+	int seenCorners = 0, seenEdges = 0, twist = 0, flip = 0;
+
+	for (int slot = 0; slot < CubeState::CORNER_COUNT; ++slot)
+	{
+		corners[slot] = cube.GetCornerPiece(slot);
+		seenCorners |= 1 << corners[slot];
+		twist += cube.GetCornerTwist(slot);
+	}
+	for (int slot = 0; slot < CubeState::EDGE_COUNT; ++slot)
+	{
+		edges[slot] = cube.GetEdgePiece(slot);
+		if (edges[slot] < CubeState::EDGE_COUNT)
+			seenEdges |= 1 << edges[slot];
+		flip += cube.GetEdgeFlip(slot);
+	}
+
+	return seenCorners == 0xFF && seenEdges == 0xFFF && twist % 3 == 0 && flip % 2 == 0
+		&& Parity(corners, CubeState::CORNER_COUNT) == Parity(edges, CubeState::EDGE_COUNT);
+}
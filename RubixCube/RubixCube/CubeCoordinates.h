@@ -0,0 +1,45 @@
+#pragma once
+#include "CubeState.h"
+
+// Maps parts of a CubeState onto dense integers and back, as used for the solver tables.
+// Setters only touch the pieces the coordinate describes.
+class CubeCoordinates
+{
+public:
+	static const int TWIST_COUNT = 2187;       // 3^7 orientations of the corners
+	static const int FLIP_COUNT = 2048;        // 2^11 orientations of the edges
+	static const int SLICE_COUNT = 495;        // 12 choose 4 positions of the FR, FL, BL, BR edges
+	static const int CORNER_PERM_COUNT = 40320; // 8! corner permutations
+	static const int EDGE8_PERM_COUNT = 40320; // 8! permutations of the U and D layer edges (slice edges in the slice)
+	static const int SLICE_PERM_COUNT = 24;    // 4! permutations of the slice edges inside the slice
+	static const int EDGE6_POSITION_COUNT = 665280; // 12! / 6! placements of six edges
+	static const int EDGE6_COMBINATION_COUNT = 924; // 12 choose 6 slots occupied by them
+	static const int EDGE6_FLIP_COUNT = 64;    // 2^6 orientations of six edges
+
+	static int GetTwist(const CubeState& cube);
+	static void SetTwist(CubeState& cube, int twist);
+	static int GetFlip(const CubeState& cube);
+	static void SetFlip(CubeState& cube, int flip);
+	static int GetSlice(const CubeState& cube);
+	static void SetSlice(CubeState& cube, int slice); // also places the remaining edges
+	static int GetCornerPerm(const CubeState& cube);
+	static void SetCornerPerm(CubeState& cube, int perm);
+	static int GetEdge8Perm(const CubeState& cube);
+	static void SetEdge8Perm(CubeState& cube, int perm);
+	static int GetSlicePerm(const CubeState& cube);
+	static void SetSlicePerm(CubeState& cube, int perm);
+
+	// The six edges firstPiece..firstPiece+5. Slots are counted from firstPiece on so that the solved cube is 0.
+	// The position is combination * 720 + order of the pieces inside it, the flip lists the slots of the combination in order.
+	static int GetEdge6Position(const CubeState& cube, int firstPiece);
+	static void SetEdge6Position(CubeState& cube, int firstPiece, int position); // places all edges unflipped
+	static int GetEdge6Flip(const CubeState& cube, int firstPiece);
+	static void SetEdge6Flip(CubeState& cube, int firstPiece, int flip);
+
+	// rank of a permutation of 0..count-1 (Lehmer code) and its inverse
+	static int RankPermutation(const int* permutation, int count);
+	static void UnrankPermutation(int rank, int* permutation, int count);
+
+	// true if the pieces form a valid permutation, the orientations add up and both permutations have the same parity
+	static bool IsSolvable(const CubeState& cube);
+};
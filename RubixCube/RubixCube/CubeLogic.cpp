@@ -4,15 +4,37 @@
 #include <mmsystem.h>
 //
 #include "CubeLogic.h"
+#include "CubeMoveTables.h"
 #include <glm/glm.hpp>
 #include <glm/ext.hpp> 
 #include <GLFW/glfw3.h>
 #include <iostream>
 #include <iomanip>
+#include <chrono>
+#include <cstring>
+
+namespace
+{
+	// the cubies a move turns, as bit mask in the layout of CubeLogic::m_changedCubies
+	std::uint32_t GetLayerCubies(Move move)
+	{
+		const CubeMoveTables::LayerDefinition& layer = CubeMoveTables::LAYER_DEFINITIONS[move / 3];
+		std::uint32_t cubies = 0;
+		for (int cubie = 0; cubie < 27; ++cubie)
+		{
+			CubeMoveTables::IntVec position = { cubie / 9 - 1, cubie / 3 % 3 - 1, cubie % 3 - 1 };
+			if (CubeMoveTables::IsInLayer(position, layer))
+				cubies |= 1u << cubie;
+		}
+		return cubies;
+	}
+}
 
 void CubeLogic::Initialize(GLFWwindow* window)
 {
-	m_cubieRenderer.Initialize();
+	m_shaders.Initialize();
+	m_cubieRenderer.Initialize(&m_shaders);
+	m_camera.Initialize();
 
 	m_input.SetWindow(window);
 
@@ -20,6 +42,9 @@ void CubeLogic::Initialize(GLFWwindow* window)
 	m_input.ObserveKey(GLFW_KEY_SPACE);
 	m_input.ObserveKey(GLFW_KEY_R);
 
+	// solve the cube
+	m_input.ObserveKey(GLFW_KEY_S);
+
 	// arrow keys
 	m_input.ObserveKey(GLFW_KEY_RIGHT);
 	m_input.ObserveKey(GLFW_KEY_LEFT);
@@ -42,6 +67,8 @@ void CubeLogic::Initialize(GLFWwindow* window)
 
 	// quaternion for transformation of whole cube
 	m_orientationQuaternion = glm::quat(1.0f, glm::vec3(0.0f, 0.0f, 0.0f));
+	m_previousOrientation = m_orientationQuaternion;
+	m_orientationMatrix = glm::mat4(1.0f);
 
 	// fill m_cubies with their rotation matrices
 	SetUpCubies();
@@ -50,484 +77,126 @@ void CubeLogic::Initialize(GLFWwindow* window)
 void CubeLogic::SetUpCubies()
 {
 	float gapBetweenCubies = 0.05f;
-	float offset = m_cubieRenderer.GetCubieExtension() + gapBetweenCubies;
-	for (int i = 0; i < 3; ++i)
-	{
-		for (int j = 0; j < 3; ++j)
-		{
-			for (int k = 0; k < 3; ++k)
-			{
-				m_cubies[i][j][k] = glm::mat4(1.0f);
-				m_cubies[i][j][k] = glm::translate(glm::mat4(1.0f), glm::vec3((i - 1) * offset, (j - 1) * offset, (k - 1) * offset));
-				startingPositions[i][j][k] = glm::mat4(1.0f);
-				startingPositions[i][j][k] = glm::translate(glm::mat4(1.0f), glm::vec3((i - 1) * offset, (j - 1) * offset, (k - 1) * offset));
-			}
-		}
-	}
-
-	middleCubies[0] = &m_cubies[1][0][1];
-	middleCubies[1] = &m_cubies[1][1][0];
-	middleCubies[2] = &m_cubies[2][1][1];
-	middleCubies[3] = &m_cubies[1][1][2];
-	middleCubies[4] = &m_cubies[0][1][1];
-	middleCubies[5] = &m_cubies[1][2][1];
+	m_cubieDistance = m_cubieRenderer.GetCubieExtension() + gapBetweenCubies;
+	m_cubeState = CubeState();
+	UpdateCubieTransforms();
 }
 
-void CubeLogic::Render(float aspectRatio)
+void CubeLogic::UpdateCubieTransforms(std::uint32_t cubies)
 {
-	glm::mat4 globalTransformation = glm::perspective(glm::radians(45.0f), aspectRatio, 0.1f, 100.0f) // object to screen space coordinates
-		* glm::lookAt(glm::vec3(0.0f, 0.0f, 9.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
-
-	glm::mat4 cubieTransform = glm::mat4(1.0f);
+	m_changedCubies |= cubies;
+	++m_cubieVersion;
 	for (int i = 0; i < 3; ++i)
 	{
 		for (int j = 0; j < 3; ++j)
 		{
 			for (int k = 0; k < 3; ++k)
 			{
-				cubieTransform = globalTransformation * m_cubies[i][j][k];
-				m_cubieRenderer.Render(cubieTransform);
+				if ((cubies & (1u << (9 * i + 3 * j + k))) == 0)
+					continue; // not turned, its transform is still valid
+
+				int rotation[3][3];
+				m_cubeState.GetCubieRotation(i, j, k, rotation);
+
+				glm::mat4 cubie = glm::mat4(1.0f);
+				for (int column = 0; column < 3; ++column)
+					for (int row = 0; row < 3; ++row)
+						cubie[column][row] = static_cast<float>(rotation[column][row]);
+				cubie[3] = glm::vec4((i - 1) * m_cubieDistance, (j - 1) * m_cubieDistance, (k - 1) * m_cubieDistance, 1.0f);
+				m_cubies[i][j][k] = cubie;
 			}
 		}
 	}
 }
 
-void CubeLogic::ClearResources()
-{
-	m_cubieRenderer.ClearResources();
-}
-
-void CubeLogic::RotateCube()
+void CubeLogic::Render(float aspectRatio)
 {
-	for (int i = 0; i < 3; ++i)
-	{
-		for (int j = 0; j < 3; ++j)
-		{
-			for (int k = 0; k < 3; ++k)
-			{
-				m_cubies[i][j][k] = glm::mat4_cast(m_orientationQuaternion) * m_cubies[i][j][k];
-			}
-		}
-	}
+	Render(aspectRatio, 1.0);
 }
 
-void CubeLogic::FindMiddleCubie(char axis, int layer)
+void CubeLogic::UpdateCamera(float aspectRatio)
 {
-	if (layer == 1)
+	if (aspectRatio != m_cameraAspectRatio)
 	{
-		middleCubie = &m_cubies[1][1][1];
+		m_camera.Update(glm::perspective(glm::radians(45.0f), aspectRatio, 0.1f, 100.0f) // world to screen space coordinates
+			* glm::lookAt(glm::vec3(0.0f, 0.0f, 9.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f)));
+		m_cameraAspectRatio = aspectRatio;
 	}
 	else
-	{
-		if (axis == 'x')
-		{
-			if (layer == 0)
-			{
-				float xMin = std::min({
-					(*middleCubies[0])[3][0],
-					(*middleCubies[1])[3][0],
-					(*middleCubies[2])[3][0],
-					(*middleCubies[3])[3][0],
-					(*middleCubies[4])[3][0],
-					(*middleCubies[5])[3][0] });
-
-				for (int i = 0; i < 6; ++i)
-				{
-					if ((*middleCubies[i])[3][0] == xMin)
-					{
-						middleCubie = middleCubies[i];
-						break;
-					}
-				}
-			}
-			else if (layer == 2)
-			{
-				float xMax = std::max({
-					(*middleCubies[0])[3][0],
-					(*middleCubies[1])[3][0],
-					(*middleCubies[2])[3][0],
-					(*middleCubies[3])[3][0],
-					(*middleCubies[4])[3][0],
-					(*middleCubies[5])[3][0] });
-
-				for (int i = 0; i < 6; ++i)
-				{
-					if ((*middleCubies[i])[3][0] == xMax)
-					{
-						middleCubie = middleCubies[i];
-						break;
-					}
-				}
-			}
-		}
-		else if (axis == 'y')
-		{
-			if (layer == 0)
-			{
-				float yMin = std::min({
-					(*middleCubies[0])[3][1],
-					(*middleCubies[1])[3][1],
-					(*middleCubies[2])[3][1],
-					(*middleCubies[3])[3][1],
-					(*middleCubies[4])[3][1],
-					(*middleCubies[5])[3][1] });
-
-				for (int i = 0; i < 6; ++i)
-				{
-					if ((*middleCubies[i])[3][1] == yMin)
-					{
-						middleCubie = middleCubies[i];
-						break;
-					}
-				}
-			}
-			else if (layer == 2)
-			{
-				float yMax = std::max({
-					(*middleCubies[0])[3][1],
-					(*middleCubies[1])[3][1],
-					(*middleCubies[2])[3][1],
-					(*middleCubies[3])[3][1],
-					(*middleCubies[4])[3][1],
-					(*middleCubies[5])[3][1] });
-
-				for (int i = 0; i < 6; ++i)
-				{
-					if ((*middleCubies[i])[3][1] == yMax)
-					{
-						middleCubie = middleCubies[i];
-						break;
-					}
-				}
-			}
-		}
-	}
-}
-
-void CubeLogic::FindLayer(char axis, int layer)
-{
-	/*
-	y\x	 0 1 2
-	  2 [][][]
-	  1 [][][]
-	  0 [][][]
-	*/
-	if (middleCubie == &m_cubies[1][1][1])
-	{
-		FindMiddleLayer(axis);
-	} // layers are all defined circular and counter clockwise and the last cubie is always the middleCubie
-	else if (middleCubie == &m_cubies[1][0][1])
-	{
-		currentLayer[0] = &m_cubies[0][0][0];
-		currentLayer[1] = &m_cubies[0][0][1];
-		currentLayer[2] = &m_cubies[0][0][2];
-		currentLayer[3] = &m_cubies[1][0][2];
-		currentLayer[4] = &m_cubies[2][0][2];
-		currentLayer[5] = &m_cubies[2][0][1];
-		currentLayer[6] = &m_cubies[2][0][0];
-		currentLayer[7] = &m_cubies[1][0][0];
-		currentLayer[8] = &m_cubies[1][0][1];
-	}
-	else if (middleCubie == &m_cubies[1][1][0])
-	{
-		currentLayer[0] = &m_cubies[0][0][0];
-		currentLayer[1] = &m_cubies[1][0][0];
-		currentLayer[2] = &m_cubies[2][0][0];
-		currentLayer[3] = &m_cubies[2][1][0];
-		currentLayer[4] = &m_cubies[2][2][0];
-		currentLayer[5] = &m_cubies[1][2][0];
-		currentLayer[6] = &m_cubies[0][2][0];
-		currentLayer[7] = &m_cubies[0][1][0];
-		currentLayer[8] = &m_cubies[1][1][0];
-	}
-	else if (middleCubie == &m_cubies[0][1][1])
-	{
-		currentLayer[0] = &m_cubies[0][0][0];
-		currentLayer[1] = &m_cubies[0][1][0];
-		currentLayer[2] = &m_cubies[0][2][0];
-		currentLayer[3] = &m_cubies[0][2][1];
-		currentLayer[4] = &m_cubies[0][2][2];
-		currentLayer[5] = &m_cubies[0][1][2];
-		currentLayer[6] = &m_cubies[0][0][2];
-		currentLayer[7] = &m_cubies[0][0][1];
-		currentLayer[8] = &m_cubies[0][1][1];
-	}
-	else if (middleCubie == &m_cubies[2][1][1])
-	{
-		currentLayer[0] = &m_cubies[2][0][0];
-		currentLayer[1] = &m_cubies[2][1][0];
-		currentLayer[2] = &m_cubies[2][2][0];
-		currentLayer[3] = &m_cubies[2][2][1];
-		currentLayer[4] = &m_cubies[2][2][2];
-		currentLayer[5] = &m_cubies[2][1][2];
-		currentLayer[6] = &m_cubies[2][0][2];
-		currentLayer[7] = &m_cubies[2][0][1];
-		currentLayer[8] = &m_cubies[2][1][1];
-	}
-	else if (middleCubie == &m_cubies[1][1][2])
-	{
-		currentLayer[0] = &m_cubies[0][0][2];
-		currentLayer[1] = &m_cubies[1][0][2];
-		currentLayer[2] = &m_cubies[2][0][2];
-		currentLayer[3] = &m_cubies[2][1][2];
-		currentLayer[4] = &m_cubies[2][2][2];
-		currentLayer[5] = &m_cubies[1][2][2];
-		currentLayer[6] = &m_cubies[0][2][2];
-		currentLayer[7] = &m_cubies[0][1][2];
-		currentLayer[8] = &m_cubies[1][1][2];
-	}
-	else if (middleCubie == &m_cubies[1][2][1])
-	{
-		currentLayer[0] = &m_cubies[0][2][0];
-		currentLayer[1] = &m_cubies[0][2][1];
-		currentLayer[2] = &m_cubies[0][2][2];
-		currentLayer[3] = &m_cubies[1][2][2];
-		currentLayer[4] = &m_cubies[2][2][2];
-		currentLayer[5] = &m_cubies[2][2][1];
-		currentLayer[6] = &m_cubies[2][2][0];
-		currentLayer[7] = &m_cubies[1][2][0];
-		currentLayer[8] = &m_cubies[1][2][1];
-	}
+		m_camera.Bind();
 }
 
-void CubeLogic::FindMiddleLayer(char axis)
+void CubeLogic::Render(float aspectRatio, double interpolation)
 {
-	// layer representatives
-	glm::vec3 rep1, rep2, rep3;
-	rep1 = m_cubies[2][1][1][3];
-	rep2 = m_cubies[1][2][1][3];
-	rep3 = m_cubies[1][1][2][3];
-	float rep1_rep2 = 0.0f, rep2_rep3 = 0.0f, rep3_rep1 = 0.0f, smallest = 0.0f;
-	if (axis == 'x') // look for the two representive cubies which have the lowest combined x position values
-	{
-		rep1_rep2 = std::abs(rep1.x) + std::abs(rep2.x); //absolute value to determine the rep-combination which is nearest to zero
-		rep2_rep3 = std::abs(rep2.x) + std::abs(rep3.x);
-		rep3_rep1 = std::abs(rep3.x) + std::abs(rep1.x);
-	}
-	else if (axis == 'y') // look for the two representive cubies which have the lowest combined y values
-	{
-		rep1_rep2 = std::abs(rep1.y) + std::abs(rep2.y);
-		rep2_rep3 = std::abs(rep2.y) + std::abs(rep3.y);
-		rep3_rep1 = std::abs(rep3.y) + std::abs(rep1.y);
-	}
-	smallest = std::min({ rep1_rep2, rep2_rep3, rep3_rep1 });
-	if (smallest == rep1_rep2) // z-layer
-	{
-		if ((axis == 'x' && rep3.x < 0.0f) || (axis == 'y' && rep3.y < 0.0f)) // direction determination of circular layer defintion
-		{
-			currentLayer[0] = &m_cubies[0][0][1];
-			currentLayer[1] = &m_cubies[0][1][1];
-			currentLayer[2] = &m_cubies[0][2][1];
-			currentLayer[3] = &m_cubies[1][2][1];
-			currentLayer[4] = &m_cubies[2][2][1];
-			currentLayer[5] = &m_cubies[2][1][1];
-			currentLayer[6] = &m_cubies[2][0][1];
-			currentLayer[7] = &m_cubies[1][0][1];
-			currentLayer[8] = &m_cubies[1][1][1];
-		}
-		else
-		{
-			currentLayer[0] = &m_cubies[0][0][1];
-			currentLayer[1] = &m_cubies[1][0][1];
-			currentLayer[2] = &m_cubies[2][0][1];
-			currentLayer[3] = &m_cubies[2][1][1];
-			currentLayer[4] = &m_cubies[2][2][1];
-			currentLayer[5] = &m_cubies[1][2][1];
-			currentLayer[6] = &m_cubies[0][2][1];
-			currentLayer[7] = &m_cubies[0][1][1];
-			currentLayer[8] = &m_cubies[1][1][1];
-		}
+	m_shaders.Update();
+	UpdateCamera(aspectRatio);
 
-	}
-	else if (smallest == rep2_rep3) // x-layer
-	{
-		if ((axis == 'x' && rep1.x < 0.0f) || (axis == 'y' && rep1.y < 0.0f))
-		{
-			currentLayer[0] = &m_cubies[1][0][0];
-			currentLayer[1] = &m_cubies[1][0][1];
-			currentLayer[2] = &m_cubies[1][0][2];
-			currentLayer[3] = &m_cubies[1][1][2];
-			currentLayer[4] = &m_cubies[1][2][2];
-			currentLayer[5] = &m_cubies[1][2][1];
-			currentLayer[6] = &m_cubies[1][2][0];
-			currentLayer[7] = &m_cubies[1][1][0];
-			currentLayer[8] = &m_cubies[1][1][1];
-		}
-		else
-		{
-			currentLayer[0] = &m_cubies[1][0][0];
-			currentLayer[1] = &m_cubies[1][1][0];
-			currentLayer[2] = &m_cubies[1][2][0];
-			currentLayer[3] = &m_cubies[1][2][1];
-			currentLayer[4] = &m_cubies[1][2][2];
-			currentLayer[5] = &m_cubies[1][1][2];
-			currentLayer[6] = &m_cubies[1][0][2];
-			currentLayer[7] = &m_cubies[1][0][1];
-			currentLayer[8] = &m_cubies[1][1][1];
-		}
-	}
-	else if (smallest == rep3_rep1) // y-layer
+	if (m_changedCubies != 0) // the cubie transforms are stored contiguously, one upload covers the changed range
 	{
-		if ((axis == 'x' && rep2.x < 0.0f) || (axis == 'y' && rep2.y < 0.0f))
-		{
-			currentLayer[0] = &m_cubies[0][1][0];
-			currentLayer[1] = &m_cubies[1][1][0];
-			currentLayer[2] = &m_cubies[2][1][0];
-			currentLayer[3] = &m_cubies[2][1][1];
-			currentLayer[4] = &m_cubies[2][1][2];
-			currentLayer[5] = &m_cubies[1][1][2];
-			currentLayer[6] = &m_cubies[0][1][2];
-			currentLayer[7] = &m_cubies[0][1][1];
-			currentLayer[8] = &m_cubies[1][1][1];
-		}
-		else
-		{
-			currentLayer[0] = &m_cubies[0][1][0];
-			currentLayer[1] = &m_cubies[0][1][1];
-			currentLayer[2] = &m_cubies[0][1][2];
-			currentLayer[3] = &m_cubies[1][1][2];
-			currentLayer[4] = &m_cubies[2][1][2];
-			currentLayer[5] = &m_cubies[2][1][1];
-			currentLayer[6] = &m_cubies[2][1][0];
-			currentLayer[7] = &m_cubies[1][1][0];
-			currentLayer[8] = &m_cubies[1][1][1];
-		}
+		int first = 0, last = 26;
+		while ((m_changedCubies & (1u << first)) == 0)
+			++first;
+		while ((m_changedCubies & (1u << last)) == 0)
+			--last;
+		m_cubieRenderer.UpdateInstances(&m_cubies[0][0][0], first, last - first + 1);
+		m_changedCubies = 0;
 	}
-}
 
-glm::vec3 CubeLogic::FindRotationAxis(char axis, int CubieOfLayer)
-{
-	int ax = (axis == 'x') ? 0 : 1; // axis == y => 1
-	int index = CubieOfLayer;
-	// find max value of the three vectos which corresponses the most to the axis of the desired rotation
-	int prefix = 0; // default = 0, positive = 1, negative = -1
-	float max = std::max({ (*currentLayer[index])[0][ax], (*currentLayer[index])[1][ax], (*currentLayer[index])[2][ax] });
-	float min = std::min({ (*currentLayer[index])[0][ax], (*currentLayer[index])[1][ax], (*currentLayer[index])[2][ax] });
-	if (max >= min * -1) // find prefix of value which determines whether the rotation direction should be flipped or not
-	{
-		prefix = 1;
-	}
+	// multiplied with the orientation in the vertex shader; while the cube turns, it is blended between two updates
+	if (m_previousOrientation == m_orientationQuaternion || interpolation >= 1.0)
+		m_cubieRenderer.DrawInstances(m_orientationMatrix, 27);
 	else
-	{
-		prefix = -1;
-	}
-
-	int indexOfHighestAbsoluteValue = 0; // 0 => x-Vec, 1 => y-Vec, 2 => z-Vec with highest absolute value
-	for (int i = 0; i < 3; ++i)
-	{
-		if (prefix == 1)
-		{
-			if ((*currentLayer[index])[i][ax] == max)
-			{
-				indexOfHighestAbsoluteValue = i;
-				break;
-			}
-		}
-		else if (prefix == -1)
-		{
-			if ((*currentLayer[index])[i][ax] == min)
-			{
-				indexOfHighestAbsoluteValue = i;
-				break;
-			}
-		}
-	}
-
-	glm::vec3 rotationAxis = glm::vec3(0.0f);
-	if (indexOfHighestAbsoluteValue == 0) // x-vec
-	{
-		rotationAxis = glm::vec3(prefix, 0.0f, 0.0f);
-	}
-	else if (indexOfHighestAbsoluteValue == 1) // y-vec
-	{
-		rotationAxis = glm::vec3(0.0f, prefix, 0.0f);
-	}
-	else if (indexOfHighestAbsoluteValue == 2) // z-vec
-	{
-		rotationAxis = glm::vec3(0.0f, 0.0f, prefix);
-	}
-	return rotationAxis;
+		m_cubieRenderer.DrawInstances(glm::mat4_cast(glm::slerp(m_previousOrientation, m_orientationQuaternion, static_cast<float>(interpolation))), 27);
 }
 
-void CubeLogic::UpdateCubiePositions(char axis, int direction)
+void CubeLogic::Publish(double time)
 {
-	int dir = FlipCubieTranslationDirectionIfNeeded(axis, direction);
-
-	glm::vec4 newPos[8] = {};
-	if (dir == 1)
+	Snapshot& snapshot = m_snapshots.GetWriteSlot();
+	if (snapshot.cubieVersion != m_cubieVersion) // the slot may hold the cubies of an older update
 	{
-		int j = 2; // every cubie moves two positions forward
-		for (int i = 0; i < 8; ++i)
-		{
-			if (j == 8) j = 0;
-			newPos[i] = (*currentLayer[j])[3];
-			++j;
-		}
-	}
-	else if (dir == -1)
-	{
-		int j = 5;
-		for (int i = 7; i >= 0; --i)
-		{
-			if (j == -1) j = 7;
-			newPos[i] = (*currentLayer[j])[3];
-			--j;
-		}
-	}
-
-	// update positions
-	for (int i = 0; i < 8; ++i)
-	{
-		(*currentLayer[i])[3] = newPos[i];
+		std::memcpy(snapshot.cubies, m_cubies, sizeof(snapshot.cubies));
+		snapshot.cubieVersion = m_cubieVersion;
 	}
+	snapshot.previousOrientation = m_previousOrientation;
+	snapshot.orientation = m_orientationQuaternion;
+	snapshot.time = time;
+	snapshot.stepDuration = m_lastDeltaTime;
+	m_snapshots.Publish();
 }
 
-void CubeLogic::UpdateCubieIndices(char axis, int direction)
+void CubeLogic::RenderPublished(float aspectRatio, double time)
 {
-	int dir = FlipCubieTranslationDirectionIfNeeded(axis, direction);
+	const Snapshot& snapshot = m_snapshots.Read();
+	if (snapshot.cubieVersion == 0)
+		return; // nothing published yet
 
-	glm::mat4 tempLayer[8] = {};
-	if (dir == 1)
-	{
-		int j = 2;
-		for (int i = 0; i < 8; ++i)
-		{
-			if (j == 8) j = 0;
-			tempLayer[j] = *currentLayer[i];
-			++j;
-		}
-	}
-	else if (dir == -1)
-	{
-		int j = 5;
-		for (int i = 7; i >= 0; --i)
-		{
-			if (j == -1) j = 7;
-			tempLayer[j] = *currentLayer[i];
-			--j;
-		}
-	}
-	for (int i = 0; i < 8; ++i) // upadte index after new position
+	m_shaders.Update();
+	UpdateCamera(aspectRatio);
+	if (snapshot.cubieVersion != m_uploadedVersion)
 	{
-		*currentLayer[i] = tempLayer[i];
+		m_cubieRenderer.UpdateInstances(snapshot.cubies, 0, 27);
+		m_uploadedVersion = snapshot.cubieVersion;
 	}
+
+	// one update behind: the orientation moves from the previous to the published one until the next update is due
+	float interpolation = snapshot.stepDuration > 0.0 ? static_cast<float>((time - snapshot.time) / snapshot.stepDuration) : 1.0f;
+	interpolation = glm::clamp(interpolation, 0.0f, 1.0f);
+	m_cubieRenderer.DrawInstances(glm::mat4_cast(glm::slerp(snapshot.previousOrientation, snapshot.orientation, interpolation)), 27);
 }
 
-int CubeLogic::FlipCubieTranslationDirectionIfNeeded(char axis, int direction)
+void CubeLogic::ClearResources()
 {
-	if (((middleCubie == &m_cubies[2][1][1] || middleCubie == &m_cubies[1][2][1] || middleCubie == &m_cubies[1][1][2])
-		&& ((axis == 'x' && (*middleCubie)[3].x < 0.0f) || (axis == 'y' && (*middleCubie)[3].y < 0.0f)))
-		||
-		((middleCubie == &m_cubies[1][1][0] || middleCubie == &m_cubies[0][1][1] || middleCubie == &m_cubies[1][0][1])
-			&& ((axis == 'x' && (*middleCubie)[3].x > 0.0f) || (axis == 'y' && (*middleCubie)[3].y > 0.0f))))
-	{
-		direction = -direction;
-	}
-	return direction;
+	m_input.StopRecording();
+	m_shaders.ClearResources();
+	m_camera.ClearResources();
+	m_cubieRenderer.ClearResources();
 }
 
 void CubeLogic::PlayRotationSound()
 {
+	if (!m_soundEnabled)
+		return;
+
 	int r = std::rand() % 5; // random number
 	std::string sound = r == 0 ? "Sound1.wav" : r == 1 ? "Sound2.wav" : r == 2 ? "Sound3.wav" : r == 3 ? "Sound4.wav" : "Sound5.wav";
 	std::string soundPath = "..\\Sounds\\" + sound;
@@ -537,40 +206,46 @@ void CubeLogic::PlayRotationSound()
 
 void CubeLogic::RotateLayer(char axis, int direction, int layer)
 {
-	FindMiddleCubie(axis, layer);
-	FindLayer(axis, layer);
-
-	glm::vec3 rotationAxis = glm::vec3(0.0f);
-	for (int i = 0; i < 9; ++i)
-	{
-		rotationAxis = FindRotationAxis(axis, i);
-		*currentLayer[i] = glm::rotate(*currentLayer[i], glm::radians(90.0f * direction), rotationAxis);
-	}
+	Move move = FindLayerMove(axis, direction, layer);
+	if (move == MOVE_COUNT)
+		return;
 
-	UpdateCubiePositions(axis, direction);
-	UpdateCubieIndices(axis, direction);
+	m_cubeState.ApplyMove(move);
+	UpdateCubieTransforms(GetLayerCubies(move));
 
 	PlayRotationSound();
 }
 
-void CubeLogic::ResetPosition()
+Move CubeLogic::FindLayerMove(char axis, int direction, int layer) const
 {
-	for (int x = 0; x < 3; ++x)
+	// bring the screen axis into the cube's frame and pick the cube axis that is closest to it
+	glm::vec3 screenAxis = (axis == 'x') ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+	glm::vec3 cubeAxis = glm::conjugate(m_orientationQuaternion) * screenAxis;
+
+	int ax = 0;
+	for (int i = 1; i < 3; ++i)
 	{
-		for (int y = 0; y < 3; ++y)
-		{
-			for (int z = 0; z < 3; ++z)
-			{
-				m_cubies[x][y][z] = startingPositions[x][y][z];
-			}
-		}
+		if (std::abs(cubeAxis[i]) > std::abs(cubeAxis[ax]))
+			ax = i;
 	}
+	int sign = (cubeAxis[ax] < 0.0f) ? -1 : 1; // a flipped axis mirrors the layer index and the turn direction
+
+	return CubeState::FindLayerMove(ax, (sign == 1) ? layer : 2 - layer, direction * sign);
 }
 
-void CubeLogic::HandleArrowKeys(double deltaTime)
+void CubeLogic::ResetPosition()
 {
-	m_input.Update();
 	m_orientationQuaternion = glm::quat(1.0f, glm::vec3(0.0f, 0.0f, 0.0f));
+	m_previousOrientation = m_orientationQuaternion;
+	m_orientationMatrix = glm::mat4(1.0f);
+	m_cubeState = CubeState();
+	m_solution.clear();
+	UpdateCubieTransforms();
+}
+
+void CubeLogic::HandleArrowKeys(double deltaTime)
+{
+	m_input.Update(deltaTime);
 
 	float xVel = 0.0f;
 	if (m_input.IsKeyDown(GLFW_KEY_UP))
@@ -584,14 +259,21 @@ void CubeLogic::HandleArrowKeys(double deltaTime)
 	if (m_input.IsKeyDown(GLFW_KEY_LEFT))
 		yVel = glm::radians(-90.0f);
 
+	m_isTurning = xVel != 0.0f || yVel != 0.0f;
+	if (!m_isTurning)
+		return; // nothing to integrate
+
 	glm::quat velQuat = glm::quat(0.0f, glm::vec3(xVel, yVel, 0.0f));
 	m_orientationQuaternion += 0.5f * (float(deltaTime)) * velQuat * m_orientationQuaternion;
 	m_orientationQuaternion = normalize(m_orientationQuaternion);
-	RotateCube();
+	m_orientationMatrix = glm::mat4_cast(m_orientationQuaternion);
 }
 
 void CubeLogic::HandleNumpadKeys()
 {
+	if (m_solutionStep < m_solution.size()) // no manual turns while a solution is played
+		return;
+
 	if (m_input.IsKeyDown(GLFW_KEY_LEFT_SHIFT))
 	{ // vertical rotation
 		if (m_input.WasKeyPressed(GLFW_KEY_KP_9))
@@ -626,6 +308,61 @@ void CubeLogic::HandleNumpadKeys()
 	}
 }
 
+void CubeLogic::HandleSolveKey()
+{
+	if (!m_input.WasKeyPressed(GLFW_KEY_S) || m_solutionStep < m_solution.size())
+		return;
+
+	if (!m_solver)
+		m_solver = std::make_unique<TwoPhaseSolver>();
+
+	// a replay has to find the same solution as the recording, however fast either machine is
+	auto start = std::chrono::steady_clock::now();
+	bool solved = m_input.IsRecording() || m_input.IsReplaying()
+		? m_solver->Solve(m_cubeState, m_solution, TwoPhaseSolver::DEFAULT_MAX_LENGTH, 0.0, TwoPhaseSolver::DEFAULT_NODE_LIMIT)
+		: m_solver->Solve(m_cubeState, m_solution);
+	double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	if (!solved)
+	{
+		std::cout << "Cube cannot be solved" << std::endl;
+		return;
+	}
+
+	std::cout << "Solution (" << m_solution.size() << " moves, " << std::fixed << std::setprecision(2) << milliseconds << " ms):";
+	for (Move move : m_solution)
+		std::cout << " " << CubeState::GetMoveName(move);
+	std::cout << std::endl;
+
+	m_solutionStep = 0;
+	m_solutionTimer = 0.0;
+}
+
+bool CubeLogic::StartReplay(const char* fileName)
+{
+	if (!m_input.StartReplay(fileName))
+		return false;
+	if (!m_solver) // before the frames are measured
+		m_solver = std::make_unique<TwoPhaseSolver>();
+	return true;
+}
+
+void CubeLogic::PlaySolution(double deltaTime)
+{
+	const double secondsPerMove = 0.3;
+	if (m_solutionStep >= m_solution.size())
+		return;
+
+	m_solutionTimer += deltaTime;
+	if (m_solutionTimer < secondsPerMove)
+		return;
+	m_solutionTimer -= secondsPerMove;
+
+	Move move = m_solution[m_solutionStep++];
+	m_cubeState.ApplyMove(move);
+	UpdateCubieTransforms(GetLayerCubies(move));
+	PlayRotationSound();
+}
+
 void CubeLogic::ShowMatrixOfCubie()
 {
 	// reset position
@@ -635,7 +372,7 @@ void CubeLogic::ShowMatrixOfCubie()
 	if (m_input.WasKeyPressed(GLFW_KEY_SPACE))
 	{
 		float x1, y1, z1, w1, x2, y2, z2, w2, x3, y3, z3, w3, x4, y4, z4, w4;
-		glm::mat4 m = m_cubies[2][1][2];
+		glm::mat4 m = glm::mat4_cast(m_orientationQuaternion) * m_cubies[2][1][2];
 		x1 = m[0][0];x2 = m[1][0];x3 = m[2][0];x4 = m[3][0];
 		y1 = m[0][1];y2 = m[1][1];y3 = m[2][1];y4 = m[3][1];
 		z1 = m[0][2];z2 = m[1][2];z3 = m[2][2];z4 = m[3][2];
@@ -652,7 +389,11 @@ void CubeLogic::ShowMatrixOfCubie()
 
 void CubeLogic::Update(double deltaTime)
 {
+	m_previousOrientation = m_orientationQuaternion;
+	m_lastDeltaTime = deltaTime;
 	HandleArrowKeys(deltaTime);
 	HandleNumpadKeys();
+	HandleSolveKey();
+	PlaySolution(deltaTime);
 	ShowMatrixOfCubie();
 }
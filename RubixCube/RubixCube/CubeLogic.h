@@ -1,46 +1,89 @@
 #pragma once
 #include "GameInterface.h"
+#include "CameraUniforms.h"
 #include "CubieRenderer.h"
 #include "InputSystem.h"
+#include "ShaderManager.h"
+#include "CubeState.h"
+#include "TripleBuffer.h"
+#include "TwoPhaseSolver.h"
 #include <glm/ext/quaternion_float.hpp>
+#include <cstdint>
+#include <memory>
+#include <vector>
 
 class CubeLogic : public GameInterface
 {
 public:
 	void Initialize(GLFWwindow* window);
 	void Render(float aspectRatio);
+	void Render(float aspectRatio, double interpolation);
 	void ClearResources();
 	void Update(double deltaTime);
+	bool IsAnimating() const { return m_isTurning || m_solutionStep < m_solution.size(); }
+
+	bool SupportsRenderThread() const { return true; }
+	void Publish(double time);
+	void RenderPublished(float aspectRatio, double time);
+
+	bool StartRecording(const char* fileName) { return m_input.StartRecording(fileName); }
+	bool StartReplay(const char* fileName);
+	double GetReplayStep() const { return m_input.GetReplayStep(); }
 
 	void HandleArrowKeys(double deltaTime);
 	void HandleNumpadKeys();
+	void HandleSolveKey();
 	void ShowMatrixOfCubie();
+	void PlaySolution(double deltaTime); // applies the moves of the last solution one after another
 
 	void SetUpCubies();
 	void ResetPosition();
 
-	void RotateCube();
 	void RotateLayer(char axis, int direction, int layer);
-
-	void FindMiddleCubie(char axis, int layer);
-	void FindLayer(char axis, int layer);
-	void FindMiddleLayer(char axis);
-	glm::vec3 FindRotationAxis(char axis, int CubeOfLayer);
-
-	void UpdateCubiePositions(char axis, int direction);
-	void UpdateCubieIndices(char axis, int direction);
-	int FlipCubieTranslationDirectionIfNeeded(char axis, int direction);
+	Move FindLayerMove(char axis, int direction, int layer) const; // maps a screen aligned layer onto the cube's own axes
+	static const std::uint32_t ALL_CUBIES = (1u << 27) - 1; // bit 9i + 3j + k stands for m_cubies[i][j][k]
+	void UpdateCubieTransforms(std::uint32_t cubies = ALL_CUBIES); // rebuilds these m_cubies from m_cubeState
 
 
 	void PlayRotationSound();
+	void SetSoundEnabled(bool enabled) { m_soundEnabled = enabled; } // the benchmark turns layers without sound
 
 private:
+	// what the render thread needs of one update, see Publish
+	struct Snapshot
+	{
+		glm::mat4 cubies[27];
+		std::uint32_t cubieVersion = 0; // of m_cubieVersion when the cubies were copied
+		glm::quat previousOrientation;
+		glm::quat orientation;
+		double time = 0.0;              // when the update was finished
+		double stepDuration = 0.0;      // the next update follows this much later
+	};
+
+	void UpdateCamera(float aspectRatio);
+
 	CubieRenderer m_cubieRenderer;
+	CameraUniforms m_camera;
+	ShaderManager m_shaders;
 	InputSystem m_input;
-	glm::quat m_orientationQuaternion;
-	glm::mat4 m_cubies[3][3][3];
-	glm::mat4 startingPositions[3][3][3];
-	glm::mat4* currentLayer[9];
-	glm::mat4* middleCubies[6];
-	glm::mat4* middleCubie;
+	glm::quat m_orientationQuaternion; // orientation of the whole cube
+	glm::quat m_previousOrientation;   // before the last Update, for rendering between two updates
+	glm::mat4 m_orientationMatrix;     // the same as matrix, rebuilt only when it turns
+	float m_cameraAspectRatio = 0.0f;  // the camera buffer is only uploaded again when this changes
+	bool m_isTurning = false;          // an arrow key is held
+	CubeState m_cubeState;
+	glm::mat4 m_cubies[3][3][3]; // cubie transforms relative to the cube, built from m_cubeState
+	std::uint32_t m_changedCubies = ALL_CUBIES; // rebuilt but not uploaded to the renderer yet
+	std::uint32_t m_cubieVersion = 0;           // counts the changes of m_cubies
+	double m_lastDeltaTime = 0.0;
+
+	TripleBuffer<Snapshot> m_snapshots;     // from the update thread to the render thread
+	std::uint32_t m_uploadedVersion = 0;    // render thread: of the cubies in the instance buffer
+	float m_cubieDistance;
+	bool m_soundEnabled = true;
+
+	std::unique_ptr<TwoPhaseSolver> m_solver; // created on the first solve request or replay, building its tables takes a moment
+	std::vector<Move> m_solution;
+	size_t m_solutionStep = 0;
+	double m_solutionTimer = 0.0;
 };
\ No newline at end of file
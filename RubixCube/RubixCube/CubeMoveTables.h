@@ -0,0 +1,283 @@
+#pragma once
+#include "CubeState.h"
+
+// Slot geometry of the cube and the move tables derived from it. Everything is evaluated by the compiler,
+// so applying a move at runtime is nothing but indexing into MOVE_TABLES.
+namespace CubeMoveTables
+{
+	struct IntVec
+	{
+		int x, y, z;
+	};
+
+	constexpr bool operator==(const IntVec& a, const IntVec& b) { return a.x == b.x && a.y == b.y && a.z == b.z; }
+	constexpr bool operator!=(const IntVec& a, const IntVec& b) { return !(a == b); }
+
+	constexpr IntVec Cross(const IntVec& a, const IntVec& b)
+	{
+		return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+	}
+
+	constexpr int Dot(const IntVec& a, const IntVec& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+
+	constexpr int Component(const IntVec& v, int axis) { return axis == 0 ? v.x : axis == 1 ? v.y : v.z; }
+
+	constexpr IntVec AxisVector(int axis) { return { axis == 0, axis == 1, axis == 2 }; }
+
+	// quarter turn of v around the unit vector axis, counter clockwise for sign 1 and clockwise for -1
+	constexpr IntVec QuarterTurn(const IntVec& axis, int sign, const IntVec& v)
+	{
+		IntVec c = Cross(axis, v);
+		int d = Dot(axis, v);
+		return { sign * c.x + d * axis.x, sign * c.y + d * axis.y, sign * c.z + d * axis.z };
+	}
+
+	enum Face { U, R, F, D, L, B };
+
+	// outward normals of the faces in center order U R F D L B
+	constexpr IntVec FACE_NORMALS[6] = { { 0, 1, 0 }, { 1, 0, 0 }, { 0, 0, 1 }, { 0, -1, 0 }, { -1, 0, 0 }, { 0, 0, -1 } };
+	// per center the direction its spin is measured from
+	constexpr IntVec CENTER_TANGENTS[6] = { { 0, 0, 1 }, { 0, 1, 0 }, { 0, 1, 0 }, { 0, 0, 1 }, { 0, 1, 0 }, { 0, 1, 0 } };
+
+	// facets of every corner slot, starting with the U/D facet and going clockwise around the corner
+	constexpr int CORNER_FACETS[8][3] = {
+		{ U, R, F }, { U, F, L }, { U, L, B }, { U, B, R },
+		{ D, F, R }, { D, L, F }, { D, B, L }, { D, R, B } };
+	// facets of every edge slot, the reference facet first (U/D, or F/B for the middle layer)
+	constexpr int EDGE_FACETS[12][2] = {
+		{ U, R }, { U, F }, { U, L }, { U, B }, { D, R }, { D, F },
+		{ D, L }, { D, B }, { F, R }, { F, L }, { B, L }, { B, R } };
+
+	constexpr IntVec CornerPosition(int slot) // center of the slot in coordinates -1..1
+	{
+		return {
+			FACE_NORMALS[CORNER_FACETS[slot][0]].x + FACE_NORMALS[CORNER_FACETS[slot][1]].x + FACE_NORMALS[CORNER_FACETS[slot][2]].x,
+			FACE_NORMALS[CORNER_FACETS[slot][0]].y + FACE_NORMALS[CORNER_FACETS[slot][1]].y + FACE_NORMALS[CORNER_FACETS[slot][2]].y,
+			FACE_NORMALS[CORNER_FACETS[slot][0]].z + FACE_NORMALS[CORNER_FACETS[slot][1]].z + FACE_NORMALS[CORNER_FACETS[slot][2]].z };
+	}
+
+	constexpr IntVec EdgePosition(int slot)
+	{
+		return {
+			FACE_NORMALS[EDGE_FACETS[slot][0]].x + FACE_NORMALS[EDGE_FACETS[slot][1]].x,
+			FACE_NORMALS[EDGE_FACETS[slot][0]].y + FACE_NORMALS[EDGE_FACETS[slot][1]].y,
+			FACE_NORMALS[EDGE_FACETS[slot][0]].z + FACE_NORMALS[EDGE_FACETS[slot][1]].z };
+	}
+
+	constexpr IntVec CenterPosition(int slot) { return FACE_NORMALS[slot]; }
+
+	constexpr int FindFace(const IntVec& normal)
+	{
+		for (int face = 0; face < 6; ++face)
+			if (FACE_NORMALS[face] == normal)
+				return face;
+		return -1;
+	}
+
+	constexpr int FindCornerSlot(const IntVec& position)
+	{
+		for (int slot = 0; slot < CubeState::CORNER_COUNT; ++slot)
+			if (CornerPosition(slot) == position)
+				return slot;
+		return -1;
+	}
+
+	constexpr int FindEdgeSlot(const IntVec& position)
+	{
+		for (int slot = 0; slot < CubeState::EDGE_COUNT; ++slot)
+			if (EdgePosition(slot) == position)
+				return slot;
+		return -1;
+	}
+
+	// axis, layer (-1..1) and direction of the clockwise quarter turn of every layer in Move order (U R F D L B M E S x y z),
+	// this is the geometry behind the circular layer orderings CubeLogic used to hard-code
+	struct LayerDefinition
+	{
+		int axis;
+		int layer;
+		int turnSign;
+	};
+
+	constexpr int WHOLE_CUBE = 2; // layer of the cube rotations, they turn every layer
+
+	constexpr LayerDefinition LAYER_DEFINITIONS[MOVE_COUNT / 3] = {
+		{ 1, 1, -1 }, { 0, 1, -1 }, { 2, 1, -1 }, // U R F
+		{ 1, -1, 1 }, { 0, -1, 1 }, { 2, -1, 1 }, // D L B
+		{ 0, 0, 1 }, { 1, 0, 1 }, { 2, 0, -1 },   // M E S (follow L, D and F)
+		{ 0, WHOLE_CUBE, -1 }, { 1, WHOLE_CUBE, -1 }, { 2, WHOLE_CUBE, -1 } }; // x y z (follow R, U and F)
+
+	constexpr bool IsInLayer(const IntVec& position, const LayerDefinition& definition)
+	{
+		return definition.layer == WHOLE_CUBE || Component(position, definition.axis) == definition.layer;
+	}
+
+	// for every slot: where its new piece comes from and how much the orientation of that piece changes
+	struct MoveTable
+	{
+		std::uint8_t cornerFrom[CubeState::CORNER_COUNT];
+		std::uint8_t cornerTwist[CubeState::CORNER_COUNT];
+		std::uint8_t edgeFrom[CubeState::EDGE_COUNT];
+		std::uint8_t edgeFlip[CubeState::EDGE_COUNT];
+		std::uint8_t centerFrom[CubeState::CENTER_COUNT];
+		std::uint8_t centerSpin[CubeState::CENTER_COUNT];
+	};
+
+	struct MoveTables
+	{
+		MoveTable moves[MOVE_COUNT];
+		// packed slot value after adding an orientation change, indexed [change][packed value]
+		std::uint8_t cornerTwist[3][32];
+		std::uint8_t edgeFlip[2][32];
+		std::uint8_t centerSpin[4][32];
+	};
+
+	constexpr MoveTable BuildIdentityTable()
+	{
+		MoveTable table = {};
+		for (int slot = 0; slot < CubeState::CORNER_COUNT; ++slot)
+			table.cornerFrom[slot] = static_cast<std::uint8_t>(slot);
+		for (int slot = 0; slot < CubeState::EDGE_COUNT; ++slot)
+			table.edgeFrom[slot] = static_cast<std::uint8_t>(slot);
+		for (int slot = 0; slot < CubeState::CENTER_COUNT; ++slot)
+			table.centerFrom[slot] = static_cast<std::uint8_t>(slot);
+		return table;
+	}
+
+	constexpr MoveTable BuildQuarterTurnTable(const LayerDefinition& definition)
+	{
+		MoveTable table = BuildIdentityTable(); // untouched slots keep their piece
+		IntVec axis = AxisVector(definition.axis);
+
+		for (int from = 0; from < CubeState::CORNER_COUNT; ++from)
+		{
+			if (!IsInLayer(CornerPosition(from), definition))
+				continue;
+			int to = FindCornerSlot(QuarterTurn(axis, definition.turnSign, CornerPosition(from)));
+			int facet = FindFace(QuarterTurn(axis, definition.turnSign, FACE_NORMALS[CORNER_FACETS[from][0]]));
+			int twist = 0;
+			while (CORNER_FACETS[to][twist] != facet)
+				++twist;
+			table.cornerFrom[to] = static_cast<std::uint8_t>(from);
+			table.cornerTwist[to] = static_cast<std::uint8_t>(twist);
+		}
+
+		for (int from = 0; from < CubeState::EDGE_COUNT; ++from)
+		{
+			if (!IsInLayer(EdgePosition(from), definition))
+				continue;
+			int to = FindEdgeSlot(QuarterTurn(axis, definition.turnSign, EdgePosition(from)));
+			int facet = FindFace(QuarterTurn(axis, definition.turnSign, FACE_NORMALS[EDGE_FACETS[from][0]]));
+			table.edgeFrom[to] = static_cast<std::uint8_t>(from);
+			table.edgeFlip[to] = static_cast<std::uint8_t>(EDGE_FACETS[to][0] == facet ? 0 : 1);
+		}
+
+		for (int from = 0; from < CubeState::CENTER_COUNT; ++from)
+		{
+			if (!IsInLayer(CenterPosition(from), definition))
+				continue;
+			int to = FindFace(QuarterTurn(axis, definition.turnSign, CenterPosition(from)));
+			IntVec tangent = QuarterTurn(axis, definition.turnSign, CENTER_TANGENTS[from]);
+			int spin = 0;
+			IntVec reference = CENTER_TANGENTS[to];
+			while (reference != tangent) // count quarter turns around the new face until both tangents agree
+			{
+				reference = QuarterTurn(FACE_NORMALS[to], 1, reference);
+				++spin;
+			}
+			table.centerFrom[to] = static_cast<std::uint8_t>(from);
+			table.centerSpin[to] = static_cast<std::uint8_t>(spin);
+		}
+		return table;
+	}
+
+	// first applies a, then b
+	constexpr MoveTable Compose(const MoveTable& a, const MoveTable& b)
+	{
+		MoveTable table = {};
+		for (int slot = 0; slot < CubeState::CORNER_COUNT; ++slot)
+		{
+			table.cornerFrom[slot] = a.cornerFrom[b.cornerFrom[slot]];
+			table.cornerTwist[slot] = static_cast<std::uint8_t>((a.cornerTwist[b.cornerFrom[slot]] + b.cornerTwist[slot]) % 3);
+		}
+		for (int slot = 0; slot < CubeState::EDGE_COUNT; ++slot)
+		{
+			table.edgeFrom[slot] = a.edgeFrom[b.edgeFrom[slot]];
+			table.edgeFlip[slot] = static_cast<std::uint8_t>(a.edgeFlip[b.edgeFrom[slot]] ^ b.edgeFlip[slot]);
+		}
+		for (int slot = 0; slot < CubeState::CENTER_COUNT; ++slot)
+		{
+			table.centerFrom[slot] = a.centerFrom[b.centerFrom[slot]];
+			table.centerSpin[slot] = static_cast<std::uint8_t>((a.centerSpin[b.centerFrom[slot]] + b.centerSpin[slot]) % 4);
+		}
+		return table;
+	}
+
+	constexpr MoveTables BuildMoveTables()
+	{
+		MoveTables tables = {};
+		for (int layer = 0; layer < MOVE_COUNT / 3; ++layer) // clockwise, double and counter clockwise turn of every layer
+		{
+			MoveTable quarterTurn = BuildQuarterTurnTable(LAYER_DEFINITIONS[layer]);
+			tables.moves[3 * layer] = quarterTurn;
+			tables.moves[3 * layer + 1] = Compose(quarterTurn, quarterTurn);
+			tables.moves[3 * layer + 2] = Compose(tables.moves[3 * layer + 1], quarterTurn);
+		}
+
+		for (int value = 0; value < 32; ++value)
+		{
+			int piece = value & 7;
+			for (int change = 0; change < 3; ++change)
+				tables.cornerTwist[change][value] = static_cast<std::uint8_t>(piece | ((((value >> 3) + change) % 3) << 3));
+			for (int change = 0; change < 4; ++change)
+				tables.centerSpin[change][value] = static_cast<std::uint8_t>(piece | ((((value >> 3) + change) % 4) << 3));
+			for (int change = 0; change < 2; ++change)
+				tables.edgeFlip[change][value] = static_cast<std::uint8_t>(value ^ (change << 4));
+		}
+		return tables;
+	}
+
+	inline constexpr MoveTables MOVE_TABLES = BuildMoveTables();
+
+	// sanity checks run by the compiler: every turn is a permutation and four quarter turns restore the cube
+	constexpr bool IsValidMoveTable(const MoveTable& table)
+	{
+		int corners = 0, edges = 0, centers = 0;
+		for (int slot = 0; slot < CubeState::CORNER_COUNT; ++slot)
+			corners |= 1 << table.cornerFrom[slot];
+		for (int slot = 0; slot < CubeState::EDGE_COUNT; ++slot)
+			edges |= 1 << table.edgeFrom[slot];
+		for (int slot = 0; slot < CubeState::CENTER_COUNT; ++slot)
+			centers |= 1 << table.centerFrom[slot];
+		return corners == 0xFF && edges == 0xFFF && centers == 0x3F;
+	}
+
+	constexpr bool IsIdentityTable(const MoveTable& table)
+	{
+		MoveTable identity = BuildIdentityTable();
+		for (int slot = 0; slot < CubeState::CORNER_COUNT; ++slot)
+			if (table.cornerFrom[slot] != identity.cornerFrom[slot] || table.cornerTwist[slot] != 0)
+				return false;
+		for (int slot = 0; slot < CubeState::EDGE_COUNT; ++slot)
+			if (table.edgeFrom[slot] != identity.edgeFrom[slot] || table.edgeFlip[slot] != 0)
+				return false;
+		for (int slot = 0; slot < CubeState::CENTER_COUNT; ++slot)
+			if (table.centerFrom[slot] != identity.centerFrom[slot] || table.centerSpin[slot] != 0)
+				return false;
+		return true;
+	}
+
+	constexpr bool ValidateMoveTables()
+	{
+		for (int move = 0; move < MOVE_COUNT; ++move)
+		{
+			if (!IsValidMoveTable(MOVE_TABLES.moves[move]))
+				return false;
+			if (move % 3 == 0 && !IsIdentityTable(Compose(MOVE_TABLES.moves[move], MOVE_TABLES.moves[move + 2])))
+				return false;
+		}
+		return true;
+	}
+
+	static_assert(ValidateMoveTables(), "generated move tables are inconsistent");
+}
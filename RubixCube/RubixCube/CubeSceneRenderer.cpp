@@ -0,0 +1,410 @@
+#include "CubeSceneRenderer.h"
+#include "CameraUniforms.h"
+#include "CubeMoveTables.h"
+#include "ShaderUtil.h"
+#include <cstring>
+#include <utility>
+#include <vector>
+
+using namespace CubeMoveTables;
+
+namespace
+{
+	const int ROTATION_KEY_COUNT = 6 * 6 * 6;
+
+	// every column of a cubie rotation is a signed axis; the key combines the three of them
+	int GetRotationKey(const int rotation[3][3])
+	{
+		int key = 0;
+		for (int column = 2; column >= 0; --column)
+		{
+			int axis = 0;
+			while (rotation[column][axis] == 0)
+				++axis;
+			key = key * 6 + 2 * axis + (rotation[column][axis] < 0 ? 1 : 0);
+		}
+		return key;
+	}
+
+	glm::vec3 ToVec3(const IntVec& v)
+	{
+		return glm::vec3(static_cast<float>(v.x), static_cast<float>(v.y), static_cast<float>(v.z));
+	}
+
+	// creates the data store of the bound buffer; with buffer storage it stays mapped and the mapping is returned
+	void* CreateStreamStorage(GLenum target, std::size_t size, bool persistent)
+	{
+		if (!persistent)
+		{
+			glBufferData(target, size, nullptr, GL_STREAM_DRAW);
+			return nullptr;
+		}
+		GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT; // coherent writes need no flushing
+		glBufferStorage(target, size, nullptr, flags);
+		return glMapBufferRange(target, 0, size, flags);
+	}
+}
+
+void CubeSceneRenderer::Initialize(int maxCubeCount, Mode mode)
+{
+	float gapBetweenCubies = 0.05f; // the same as in CubeLogic
+	m_mode = mode;
+	m_cubieDistance = m_cubieRenderer.GetCubieExtension() + gapBetweenCubies;
+	m_maxCubeCount = maxCubeCount;
+	m_persistent = GLEW_ARB_buffer_storage != 0;
+	BuildRotationTables();
+	if (mode == CUBIE_MODE)
+		m_cubieRenderer.InitializeMesh();
+
+	glGenVertexArrays(1, &m_arrayObject);
+	glGenBuffers(1, &m_instanceBuffer);
+	glBindVertexArray(m_arrayObject);
+
+	int instanceAttributeCount;
+	if (mode == CUBIE_MODE)
+	{
+		m_shaderProgram = ShaderUtil::CreateShaderProgram("VertexShaderScene.glsl", "FragmentShaderColor.glsl");
+		m_cubieRenderer.BindMesh();
+		m_instanceSize = sizeof(CubieInstance) * VISIBLE_CUBIE_COUNT;
+		instanceAttributeCount = 4; // center and the three rotation columns
+	}
+	else
+	{
+		m_shaderProgram = ShaderUtil::CreateShaderProgram("VertexShaderSticker.glsl", "FragmentShaderColor.glsl");
+		glUseProgram(m_shaderProgram);
+		glUniform3fv(glGetUniformLocation(m_shaderProgram, "faceColors"), 6, &CubieRenderer::FACE_COLORS[0][0]);
+		glUniform1i(glGetUniformLocation(m_shaderProgram, "faceletFaces"), 0); // texture unit 0
+		glUseProgram(0);
+		BuildStickerMesh();
+		m_instanceSize = 3 * sizeof(float);
+		instanceAttributeCount = 1; // the cube position
+	}
+	CameraUniforms::BindBlock(m_shaderProgram);
+
+	m_regionSize = static_cast<std::size_t>(maxCubeCount) * m_instanceSize;
+	glBindBuffer(GL_ARRAY_BUFFER, m_instanceBuffer);
+	m_mappedInstances = static_cast<std::uint8_t*>(CreateStreamStorage(GL_ARRAY_BUFFER, (m_persistent ? REGION_COUNT : 1) * m_regionSize, m_persistent));
+	for (int attribute = 2; attribute < 2 + instanceAttributeCount; ++attribute) // pointed at a region in every Render call
+	{
+		glEnableVertexAttribArray(attribute);
+		glVertexAttribDivisor(attribute, 1);
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindVertexArray(0);
+
+	if (mode == STICKER_MODE) // the face index of every facelet, read by the vertex shader through a buffer texture
+	{
+		int bufferCount = m_persistent ? REGION_COUNT : 1;
+		glGenBuffers(bufferCount, m_faceletBuffers);
+		glGenTextures(bufferCount, m_faceletTextures);
+		for (int region = 0; region < bufferCount; ++region)
+		{
+			glBindBuffer(GL_TEXTURE_BUFFER, m_faceletBuffers[region]);
+			m_mappedFacelets[region] = static_cast<std::uint8_t*>(CreateStreamStorage(GL_TEXTURE_BUFFER, static_cast<std::size_t>(maxCubeCount) * FACELET_COUNT, m_persistent));
+			glBindTexture(GL_TEXTURE_BUFFER, m_faceletTextures[region]);
+			glTexBuffer(GL_TEXTURE_BUFFER, GL_R8UI, m_faceletBuffers[region]);
+		}
+		glBindTexture(GL_TEXTURE_BUFFER, 0);
+		glBindBuffer(GL_TEXTURE_BUFFER, 0);
+	}
+}
+
+void CubeSceneRenderer::BuildRotationTables()
+{
+	// the 24 rotations of the cube are the signed permutation matrices with determinant 1
+	std::uint8_t rotationByKey[ROTATION_KEY_COUNT] = {};
+	int rotationCount = 0;
+	const int permutations[6][3] = { { 0, 1, 2 }, { 1, 2, 0 }, { 2, 0, 1 }, { 0, 2, 1 }, { 2, 1, 0 }, { 1, 0, 2 } };
+	for (int permutation = 0; permutation < 6; ++permutation)
+	{
+		for (int signs = 0; signs < 8; ++signs)
+		{
+			int rotation[3][3] = {};
+			int determinant = permutation < 3 ? 1 : -1;
+			for (int column = 0; column < 3; ++column)
+			{
+				int sign = (signs >> column) & 1 ? -1 : 1;
+				rotation[column][permutations[permutation][column]] = sign;
+				determinant *= sign;
+			}
+			if (determinant != 1)
+				continue;
+
+			for (int column = 0; column < 3; ++column)
+			{
+				for (int row = 0; row < 3; ++row)
+					m_rotations[rotationCount][column][row] = static_cast<std::int8_t>(rotation[column][row] * 127);
+				m_rotations[rotationCount][column][3] = 0;
+			}
+			for (int side = 0; side < 6; ++side) // the sticker on a side came from the face the inverse rotation maps it to
+			{
+				IntVec normal = FACE_NORMALS[side];
+				IntVec home = { 0, 0, 0 };
+				home.x = rotation[0][0] * normal.x + rotation[0][1] * normal.y + rotation[0][2] * normal.z;
+				home.y = rotation[1][0] * normal.x + rotation[1][1] * normal.y + rotation[1][2] * normal.z;
+				home.z = rotation[2][0] * normal.x + rotation[2][1] * normal.y + rotation[2][2] * normal.z;
+				m_stickerFace[rotationCount][side] = static_cast<std::uint8_t>(FindFace(home));
+			}
+			rotationByKey[GetRotationKey(rotation)] = static_cast<std::uint8_t>(rotationCount++);
+		}
+	}
+
+	// the rotation of a cubie only depends on its slot and on piece and orientation there
+	int visibleCount = 0;
+	for (int grid = 0; grid < 27; ++grid)
+	{
+		int x = grid % 3, y = grid / 3 % 3, z = grid / 9;
+		IntVec position = { x - 1, y - 1, z - 1 };
+		int kind = (position.x != 0) + (position.y != 0) + (position.z != 0);
+		if (kind == 0)
+			continue; // the core is hidden inside the cube
+
+		int slot = kind == 3 ? FindCornerSlot(position) : kind == 2 ? FindEdgeSlot(position) : FindFace(position);
+		m_visibleCubies[visibleCount++] = { static_cast<std::uint8_t>(grid), static_cast<std::uint8_t>(kind), static_cast<std::uint8_t>(slot), ToVec3(position) * m_cubieDistance };
+
+		int pieceCount = kind == 3 ? CubeState::CORNER_COUNT : kind == 2 ? CubeState::EDGE_COUNT : CubeState::CENTER_COUNT;
+		int orientationCount = kind == 3 ? 3 : kind == 2 ? 2 : 4;
+		for (int piece = 0; piece < pieceCount; ++piece)
+		{
+			for (int orientation = 0; orientation < orientationCount; ++orientation)
+			{
+				CubeState cube;
+				if (kind == 3)
+					cube.SetCorner(slot, piece, orientation);
+				else if (kind == 2)
+					cube.SetEdge(slot, piece, orientation);
+				else
+					cube.SetCenter(slot, piece, orientation);
+				int rotation[3][3];
+				cube.GetCubieRotation(x, y, z, rotation);
+				m_rotationIndex[grid][piece][orientation] = rotationByKey[GetRotationKey(rotation)];
+			}
+		}
+	}
+}
+
+void CubeSceneRenderer::BuildStickerMesh()
+{
+	const float stickerSize = 0.45f;  // half the width of a sticker, a cubie is 1 wide
+	const float stickerLift = 0.002f; // keeps the stickers in front of the body
+	float bodySize = m_cubieDistance + 0.5f * m_cubieRenderer.GetCubieExtension(); // half the width of the cube
+
+	std::vector<StickerVertex> vertices;
+	std::vector<std::uint16_t> indices;
+	auto addQuad = [&](const glm::vec3& center, const glm::vec3& u, const glm::vec3& v, float size, int facelet)
+		{
+			std::uint16_t first = static_cast<std::uint16_t>(vertices.size());
+			const float corners[4][2] = { { -1.0f, -1.0f }, { 1.0f, -1.0f }, { 1.0f, 1.0f }, { -1.0f, 1.0f } };
+			for (const auto& corner : corners)
+			{
+				glm::vec3 position = center + (corner[0] * u + corner[1] * v) * size;
+				vertices.push_back({ { position.x, position.y, position.z }, facelet });
+			}
+			for (int index : { 0, 1, 2, 0, 2, 3 })
+				indices.push_back(static_cast<std::uint16_t>(first + index));
+		};
+
+	for (int face = 0; face < 6; ++face)
+	{
+		IntVec normal = FACE_NORMALS[face];
+		int axis = normal.x != 0 ? 0 : normal.y != 0 ? 1 : 2;
+		IntVec u = AxisVector((axis + 1) % 3);
+		IntVec v = AxisVector((axis + 2) % 3);
+		if (Dot(Cross(u, v), normal) < 0) // counter clockwise as seen from outside, so back faces can be culled
+			std::swap(u, v);
+
+		addQuad(ToVec3(normal) * bodySize, ToVec3(u), ToVec3(v), bodySize, -1);
+		for (int a = -1; a <= 1; ++a)
+		{
+			for (int b = -1; b <= 1; ++b)
+			{
+				int facelet = face * 9 + (a + 1) * 3 + (b + 1);
+				int grid = (normal.x + a * u.x + b * v.x + 1) + 3 * (normal.y + a * u.y + b * v.y + 1) + 9 * (normal.z + a * u.z + b * v.z + 1);
+				for (int cubie = 0; cubie < VISIBLE_CUBIE_COUNT; ++cubie)
+					if (m_visibleCubies[cubie].grid == grid)
+						m_faceletCubie[facelet] = static_cast<std::uint8_t>(cubie);
+
+				glm::vec3 center = ToVec3(normal) * (bodySize + stickerLift) + (ToVec3(u) * static_cast<float>(a) + ToVec3(v) * static_cast<float>(b)) * m_cubieDistance;
+				addQuad(center, ToVec3(u), ToVec3(v), stickerSize, facelet);
+			}
+		}
+	}
+
+	glGenBuffers(2, m_meshBuffers);
+	glBindBuffer(GL_ARRAY_BUFFER, m_meshBuffers[0]);
+	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(StickerVertex), vertices.data(), GL_STATIC_DRAW);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(StickerVertex), reinterpret_cast<void*>(offsetof(StickerVertex, position)));
+	glEnableVertexAttribArray(0);
+	glVertexAttribIPointer(1, 1, GL_INT, sizeof(StickerVertex), reinterpret_cast<void*>(offsetof(StickerVertex, facelet)));
+	glEnableVertexAttribArray(1);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_meshBuffers[1]); // stays bound to the vertex array object
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(std::uint16_t), indices.data(), GL_STATIC_DRAW);
+	m_indexCount = static_cast<GLsizei>(indices.size());
+}
+
+int CubeSceneRenderer::GetRotationIndex(const CubeState& cube, const VisibleCubie& cubie) const
+{
+	if (cubie.kind == 3)
+		return m_rotationIndex[cubie.grid][cube.GetCornerPiece(cubie.slot)][cube.GetCornerTwist(cubie.slot)];
+	if (cubie.kind == 2)
+		return m_rotationIndex[cubie.grid][cube.GetEdgePiece(cubie.slot)][cube.GetEdgeFlip(cubie.slot)];
+	return m_rotationIndex[cubie.grid][cube.GetCenterPiece(cubie.slot)][cube.GetCenterSpin(cubie.slot)];
+}
+
+void CubeSceneRenderer::WriteCubieInstances(CubieInstance* instances, const CubeState* cubes, const glm::vec3* positions, int count) const
+{
+	for (int i = 0; i < count; ++i)
+	{
+		for (const VisibleCubie& cubie : m_visibleCubies)
+		{
+			instances->center[0] = positions[i].x + cubie.offset.x;
+			instances->center[1] = positions[i].y + cubie.offset.y;
+			instances->center[2] = positions[i].z + cubie.offset.z;
+			std::memcpy(instances->rotation, m_rotations[GetRotationIndex(cubes[i], cubie)], sizeof(instances->rotation));
+			++instances;
+		}
+	}
+}
+
+void CubeSceneRenderer::WriteStickerInstances(float* instances, std::uint8_t* facelets, const CubeState* cubes, const glm::vec3* positions, int count) const
+{
+	for (int i = 0; i < count; ++i)
+	{
+		*instances++ = positions[i].x;
+		*instances++ = positions[i].y;
+		*instances++ = positions[i].z;
+
+		int rotations[VISIBLE_CUBIE_COUNT];
+		for (int cubie = 0; cubie < VISIBLE_CUBIE_COUNT; ++cubie)
+			rotations[cubie] = GetRotationIndex(cubes[i], m_visibleCubies[cubie]);
+		for (int facelet = 0; facelet < FACELET_COUNT; ++facelet)
+			*facelets++ = m_stickerFace[rotations[m_faceletCubie[facelet]]][facelet / 9];
+	}
+}
+
+void* CubeSceneRenderer::BeginWrite(GLenum target, GLuint buffer, void* mapped, std::size_t size)
+{
+	glBindBuffer(target, buffer);
+	if (m_persistent)
+		return mapped;
+	return glMapBufferRange(target, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT); // a fresh data store, no waiting
+}
+
+void CubeSceneRenderer::EndWrite(GLenum target)
+{
+	if (!m_persistent)
+		glUnmapBuffer(target);
+	glBindBuffer(target, 0);
+}
+
+void CubeSceneRenderer::Render(const CubeState* cubes, const glm::vec3* positions, int count)
+{
+	if (count > m_maxCubeCount)
+		count = m_maxCubeCount;
+	if (count <= 0)
+		return;
+
+	if (m_persistent)
+	{
+		m_region = (m_region + 1) % REGION_COUNT;
+		if (m_fences[m_region] != nullptr) // only waits if the GPU is more than two frames behind
+		{
+			glClientWaitSync(m_fences[m_region], GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+			glDeleteSync(m_fences[m_region]);
+			m_fences[m_region] = nullptr;
+		}
+	}
+	std::size_t offset = m_region * m_regionSize; // of this frame's instances in the instance buffer, in bytes
+
+	void* instances = BeginWrite(GL_ARRAY_BUFFER, m_instanceBuffer, m_mappedInstances + (m_persistent ? offset : 0), count * m_instanceSize);
+	if (instances == nullptr)
+	{
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		return;
+	}
+	if (m_mode == CUBIE_MODE)
+		WriteCubieInstances(static_cast<CubieInstance*>(instances), cubes, positions, count);
+	else
+	{
+		void* facelets = BeginWrite(GL_TEXTURE_BUFFER, m_faceletBuffers[m_region], m_mappedFacelets[m_region], static_cast<std::size_t>(count) * FACELET_COUNT);
+		if (facelets != nullptr)
+		{
+			WriteStickerInstances(static_cast<float*>(instances), static_cast<std::uint8_t*>(facelets), cubes, positions, count);
+			EndWrite(GL_TEXTURE_BUFFER);
+		}
+		else
+			glBindBuffer(GL_TEXTURE_BUFFER, 0);
+	}
+	EndWrite(GL_ARRAY_BUFFER);
+
+	glUseProgram(m_shaderProgram);
+	glBindVertexArray(m_arrayObject);
+	glBindBuffer(GL_ARRAY_BUFFER, m_instanceBuffer);
+	if (m_mode == CUBIE_MODE)
+	{
+		glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(CubieInstance), reinterpret_cast<void*>(offset));
+		for (int column = 0; column < 3; ++column) // normalized, so 127 arrives as 1.0
+			glVertexAttribPointer(3 + column, 3, GL_BYTE, GL_TRUE, sizeof(CubieInstance), reinterpret_cast<void*>(offset + offsetof(CubieInstance, rotation) + 4 * column));
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+		glDrawElementsInstanced(GL_TRIANGLES, CubieRenderer::INDEX_COUNT, CubieRenderer::INDEX_TYPE, nullptr, count * VISIBLE_CUBIE_COUNT);
+	}
+	else
+	{
+		glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, static_cast<GLsizei>(m_instanceSize), reinterpret_cast<void*>(offset));
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_BUFFER, m_faceletTextures[m_region]);
+		glEnable(GL_CULL_FACE); // the body and the stickers are closed towards the outside
+		glDrawElementsInstanced(GL_TRIANGLES, m_indexCount, GL_UNSIGNED_SHORT, nullptr, count);
+		glDisable(GL_CULL_FACE);
+		glBindTexture(GL_TEXTURE_BUFFER, 0);
+	}
+
+	if (m_persistent)
+		m_fences[m_region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+	glBindVertexArray(0);
+	glUseProgram(0);
+}
+
+void CubeSceneRenderer::ClearResources()
+{
+	for (GLsync& fence : m_fences)
+	{
+		if (fence != nullptr)
+			glDeleteSync(fence);
+		fence = nullptr;
+	}
+	if (m_persistent) // mapped buffers have to be unmapped before they are deleted
+	{
+		glBindBuffer(GL_ARRAY_BUFFER, m_instanceBuffer);
+		glUnmapBuffer(GL_ARRAY_BUFFER);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		for (int region = 0; region < REGION_COUNT && m_faceletBuffers[region] != 0; ++region)
+		{
+			glBindBuffer(GL_TEXTURE_BUFFER, m_faceletBuffers[region]);
+			glUnmapBuffer(GL_TEXTURE_BUFFER);
+		}
+		glBindBuffer(GL_TEXTURE_BUFFER, 0);
+	}
+	m_mappedInstances = nullptr;
+
+	for (int region = 0; region < REGION_COUNT; ++region)
+	{
+		glDeleteTextures(1, &m_faceletTextures[region]);
+		glDeleteBuffers(1, &m_faceletBuffers[region]);
+		m_faceletTextures[region] = 0;
+		m_faceletBuffers[region] = 0;
+		m_mappedFacelets[region] = nullptr;
+	}
+	glDeleteBuffers(2, m_meshBuffers);
+	glDeleteBuffers(1, &m_instanceBuffer);
+	glDeleteVertexArrays(1, &m_arrayObject);
+	glDeleteProgram(m_shaderProgram);
+	if (m_mode == CUBIE_MODE)
+		m_cubieRenderer.ClearResources();
+}
@@ -0,0 +1,95 @@
+#pragma once
+#include "CubieRenderer.h"
+#include "CubeState.h"
+#include <glm/vec3.hpp>
+#include <GL/glew.h>
+#include <cstddef>
+#include <cstdint>
+
+// Draws many cubes at once, e.g. a wall of puzzle states, with a single instanced draw call. Two kinds of geometry:
+// CUBIE_MODE draws the 26 visible cubies of every cube with all six colored faces, one instance per cubie holding the
+// cubie center and its rotation as three signed byte columns (24 bytes instead of the 64 of a full matrix).
+// STICKER_MODE draws one instance per cube: a black body and the 54 stickers, whose colors are looked up in a table
+// of face indices per cube, so hidden faces are never rasterized and any state is shown with the same mesh.
+// The per frame data is written into persistently mapped buffers with three regions, so the CPU fills one region
+// while the GPU may still read the other two. Without ARB_buffer_storage the buffers are orphaned every frame instead.
+class CubeSceneRenderer
+{
+public:
+	enum Mode
+	{
+		CUBIE_MODE,
+		STICKER_MODE
+	};
+
+	void Initialize(int maxCubeCount, Mode mode = CUBIE_MODE);
+	// draws cube i upright around positions[i] with the camera of the Camera uniform block, see CameraUniforms;
+	// cubes beyond the maximum given to Initialize are left out
+	void Render(const CubeState* cubes, const glm::vec3* positions, int count);
+	void ClearResources();
+
+	float GetCubeExtension() const { return 2.0f * m_cubieDistance + m_cubieRenderer.GetCubieExtension(); }
+
+private:
+	struct CubieInstance
+	{
+		float center[3];
+		std::int8_t rotation[3][4]; // columns, the fourth byte only pads to 4 byte alignment
+	};
+
+	struct StickerVertex
+	{
+		float position[3];
+		std::int32_t facelet; // face * 9 + index on the face, -1 for the body
+	};
+
+	struct VisibleCubie
+	{
+		std::uint8_t grid; // x + 3y + 9z
+		std::uint8_t kind; // number of facets: 3 corner, 2 edge, 1 center
+		std::uint8_t slot;
+		glm::vec3 offset;  // of the cubie center from the cube center
+	};
+
+	static const int REGION_COUNT = 3;
+	static const int VISIBLE_CUBIE_COUNT = 26;
+	static const int ROTATION_COUNT = 24;
+	static const int FACELET_COUNT = 54;
+
+	void BuildRotationTables();
+	void BuildStickerMesh();
+	int GetRotationIndex(const CubeState& cube, const VisibleCubie& cubie) const;
+	void WriteCubieInstances(CubieInstance* instances, const CubeState* cubes, const glm::vec3* positions, int count) const;
+	void WriteStickerInstances(float* instances, std::uint8_t* facelets, const CubeState* cubes, const glm::vec3* positions, int count) const;
+	void* BeginWrite(GLenum target, GLuint buffer, void* mapped, std::size_t size); // where this frame's data goes
+	void EndWrite(GLenum target);
+
+	Mode m_mode = CUBIE_MODE;
+	CubieRenderer m_cubieRenderer; // owns the cubie mesh
+	float m_cubieDistance = 0.0f;
+	int m_maxCubeCount = 0;
+
+	std::int8_t m_rotations[ROTATION_COUNT][3][4]; // in the layout of CubieInstance::rotation
+	std::uint8_t m_stickerFace[ROTATION_COUNT][6];  // face a cubie with this rotation shows on each side
+	VisibleCubie m_visibleCubies[VISIBLE_CUBIE_COUNT];
+	std::uint8_t m_rotationIndex[27][CubeState::EDGE_COUNT][4]; // [grid][piece][twist, flip or spin]
+	std::uint8_t m_faceletCubie[FACELET_COUNT];                 // index into m_visibleCubies
+
+	GLuint m_arrayObject = 0;
+	GLuint m_instanceBuffer = 0;
+	GLuint m_shaderProgram = 0;
+	std::size_t m_instanceSize = 0; // bytes per cubie or per cube
+	std::size_t m_regionSize = 0;   // bytes of instances per region
+
+	// sticker mode only
+	GLuint m_meshBuffers[2] = {}; // vertices and indices
+	GLsizei m_indexCount = 0;
+	GLuint m_faceletBuffers[REGION_COUNT] = {};
+	GLuint m_faceletTextures[REGION_COUNT] = {};
+	std::uint8_t* m_mappedFacelets[REGION_COUNT] = {};
+
+	bool m_persistent = false;                      // with buffer storage, else only region 0 is used and orphaned
+	std::uint8_t* m_mappedInstances = nullptr;      // all regions
+	GLsync m_fences[REGION_COUNT] = {};             // signaled when the GPU is done with a region
+	int m_region = 0;
+};
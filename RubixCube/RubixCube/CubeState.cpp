@@ -0,0 +1,185 @@
+#include "CubeState.h"
+#include "CubeMoveTables.h"
+
+using namespace CubeMoveTables;
+
+namespace
+{
+	// rotation that maps the orthonormal vectors from[i] onto to[i]
+	void BuildRotation(const IntVec from[3], const IntVec to[3], int rotation[3][3])
+	{
+		for (int column = 0; column < 3; ++column)
+		{
+			for (int row = 0; row < 3; ++row)
+			{
+				rotation[column][row] = 0;
+				for (int i = 0; i < 3; ++i)
+					rotation[column][row] += Component(to[i], row) * Component(from[i], column);
+			}
+		}
+	}
+}
+
+CubeState::CubeState()
+{
+	for (int i = 0; i < CORNER_COUNT; ++i)
+		m_corners[i] = static_cast<std::uint8_t>(i);
+	for (int i = 0; i < EDGE_COUNT; ++i)
+		m_edges[i] = static_cast<std::uint8_t>(i);
+	for (int i = 0; i < CENTER_COUNT; ++i)
+		m_centers[i] = static_cast<std::uint8_t>(i);
+}
+
+void CubeState::ApplyMove(Move move)
+{
+	const MoveTables& tables = MOVE_TABLES; // generated at compile time
+	const MoveTable& table = tables.moves[move];
+	CubeState old = *this;
+
+	for (int i = 0; i < CORNER_COUNT; ++i)
+		m_corners[i] = tables.cornerTwist[table.cornerTwist[i]][old.m_corners[table.cornerFrom[i]]];
+	for (int i = 0; i < EDGE_COUNT; ++i)
+		m_edges[i] = tables.edgeFlip[table.edgeFlip[i]][old.m_edges[table.edgeFrom[i]]];
+	for (int i = 0; i < CENTER_COUNT; ++i)
+		m_centers[i] = tables.centerSpin[table.centerSpin[i]][old.m_centers[table.centerFrom[i]]];
+}
+
+bool CubeState::IsSolved() const
+{
+	for (int i = 0; i < CORNER_COUNT; ++i)
+		if (m_corners[i] != i)
+			return false;
+	for (int i = 0; i < EDGE_COUNT; ++i)
+		if (m_edges[i] != i)
+			return false;
+	return AreCentersSolved();
+}
+
+bool CubeState::AreCentersSolved() const
+{
+	for (int i = 0; i < CENTER_COUNT; ++i)
+		if (GetCenterPiece(i) != i)
+			return false;
+	return true;
+}
+
+int CubeState::FindCenterFix(Move fix[2]) const
+{
+	if (AreCentersSolved())
+		return 0;
+	for (int first = MOVE_M; first <= MOVE_S_PRIME; ++first) // all single turns before any pair
+	{
+		CubeState once = *this;
+		once.ApplyMove(static_cast<Move>(first));
+		fix[0] = static_cast<Move>(first);
+		if (once.AreCentersSolved())
+			return 1;
+	}
+	for (int first = MOVE_M; first <= MOVE_S_PRIME; ++first)
+	{
+		CubeState once = *this;
+		once.ApplyMove(static_cast<Move>(first));
+		fix[0] = static_cast<Move>(first);
+		for (int second = MOVE_M; second <= MOVE_S_PRIME; ++second)
+		{
+			if (second / 3 == first / 3) // two turns of the same slice are one turn or none
+				continue;
+			CubeState twice = once;
+			twice.ApplyMove(static_cast<Move>(second));
+			fix[1] = static_cast<Move>(second);
+			if (twice.AreCentersSolved())
+				return 2;
+		}
+	}
+	return -1;
+}
+
+bool CubeState::operator==(const CubeState& other) const
+{
+	for (int i = 0; i < CORNER_COUNT; ++i)
+		if (m_corners[i] != other.m_corners[i])
+			return false;
+	for (int i = 0; i < EDGE_COUNT; ++i)
+		if (m_edges[i] != other.m_edges[i])
+			return false;
+	for (int i = 0; i < CENTER_COUNT; ++i)
+		if (m_centers[i] != other.m_centers[i])
+			return false;
+	return true;
+}
+
+void CubeState::GetCubieRotation(int x, int y, int z, int rotation[3][3]) const
+{
+	IntVec position = { x - 1, y - 1, z - 1 };
+	IntVec from[3];
+	IntVec to[3];
+
+	int facetCount = (position.x != 0) + (position.y != 0) + (position.z != 0);
+	if (facetCount == 3) // corner: piece facet i lies on slot facet i + twist
+	{
+		int slot = FindCornerSlot(position);
+		int piece = GetCornerPiece(slot);
+		for (int i = 0; i < 3; ++i)
+		{
+			from[i] = FACE_NORMALS[CORNER_FACETS[piece][i]];
+			to[i] = FACE_NORMALS[CORNER_FACETS[slot][(i + GetCornerTwist(slot)) % 3]];
+		}
+	}
+	else if (facetCount == 2) // edge
+	{
+		int slot = FindEdgeSlot(position);
+		int piece = GetEdgePiece(slot);
+		int flip = GetEdgeFlip(slot);
+		from[0] = FACE_NORMALS[EDGE_FACETS[piece][0]];
+		from[1] = FACE_NORMALS[EDGE_FACETS[piece][1]];
+		to[0] = FACE_NORMALS[EDGE_FACETS[slot][flip]];
+		to[1] = FACE_NORMALS[EDGE_FACETS[slot][1 - flip]];
+	}
+	else if (facetCount == 1) // center: spin is counted in quarter turns around the face normal
+	{
+		int slot = FindFace(position);
+		int piece = GetCenterPiece(slot);
+		from[0] = FACE_NORMALS[piece];
+		from[1] = CENTER_TANGENTS[piece];
+		to[0] = FACE_NORMALS[slot];
+		to[1] = CENTER_TANGENTS[slot];
+		for (int i = 0; i < GetCenterSpin(slot); ++i)
+			to[1] = QuarterTurn(to[0], 1, to[1]);
+	}
+	else // core: follows the U and F centers
+	{
+		from[0] = FACE_NORMALS[U];
+		from[1] = FACE_NORMALS[F];
+		for (int slot = 0; slot < CENTER_COUNT; ++slot)
+		{
+			if (GetCenterPiece(slot) == U)
+				to[0] = FACE_NORMALS[slot];
+			if (GetCenterPiece(slot) == F)
+				to[1] = FACE_NORMALS[slot];
+		}
+	}
+	from[2] = Cross(from[0], from[1]);
+	to[2] = Cross(to[0], to[1]);
+	BuildRotation(from, to, rotation);
+}
+
+Move CubeState::FindLayerMove(int axis, int layer, int turnSign)
+{
+	for (int i = 0; i < MOVE_COUNT / 3; ++i)
+	{
+		const LayerDefinition& definition = LAYER_DEFINITIONS[i];
+		if (definition.axis == axis && definition.layer == layer - 1)
+			return static_cast<Move>(3 * i + (definition.turnSign == turnSign ? 0 : 2));
+	}
+	return MOVE_COUNT;
+}
+
+const char* CubeState::GetMoveName(Move move)
+{
+	static const char* const names[MOVE_COUNT] = {
+		"U", "U2", "U'", "R", "R2", "R'", "F", "F2", "F'",
+		"D", "D2", "D'", "L", "L2", "L'", "B", "B2", "B'",
+		"M", "M2", "M'", "E", "E2", "E'", "S", "S2", "S'",
+		"x", "x2", "x'", "y", "y2", "y'", "z", "z2", "z'" };
+	return move < MOVE_COUNT ? names[move] : "?";
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include <cstdint>
+
+// Turns of the six faces, the three middle slices and the whole cube, three each: clockwise as seen from the face,
+// double and counter clockwise. The slices follow L (M), D (E) and F (S), the cube rotations R (x), U (y) and F (z).
+enum Move : std::uint8_t
+{
+	MOVE_U, MOVE_U2, MOVE_U_PRIME, MOVE_R, MOVE_R2, MOVE_R_PRIME, MOVE_F, MOVE_F2, MOVE_F_PRIME,
+	MOVE_D, MOVE_D2, MOVE_D_PRIME, MOVE_L, MOVE_L2, MOVE_L_PRIME, MOVE_B, MOVE_B2, MOVE_B_PRIME,
+	MOVE_M, MOVE_M2, MOVE_M_PRIME, MOVE_E, MOVE_E2, MOVE_E_PRIME, MOVE_S, MOVE_S2, MOVE_S_PRIME,
+	MOVE_X, MOVE_X2, MOVE_X_PRIME, MOVE_Y, MOVE_Y2, MOVE_Y_PRIME, MOVE_Z, MOVE_Z2, MOVE_Z_PRIME,
+	MOVE_COUNT
+};
+
+// Integer representation of the cube: which piece sits in which slot and how it is twisted.
+// Slots follow the usual solver order (corners URF..DRB, edges UR..BR, centers U R F D L B),
+// the grid coordinates used by the renderer are x: L->R, y: D->U, z: B->F with 0..2 each.
+class CubeState
+{
+public:
+	static const int CORNER_COUNT = 8;
+	static const int EDGE_COUNT = 12;
+	static const int CENTER_COUNT = 6;
+
+	CubeState(); // solved cube
+
+	void ApplyMove(Move move);
+	bool IsSolved() const; // the spin of the centers is not visible on a real cube and therefore ignored
+	bool AreCentersSolved() const;
+	// up to two slice turns that bring displaced centers back; returns how many, or -1 if that is not possible
+	int FindCenterFix(Move fix[2]) const;
+	bool operator==(const CubeState& other) const;
+	bool operator!=(const CubeState& other) const { return !(*this == other); }
+
+	int GetCornerPiece(int slot) const { return m_corners[slot] & 7; }
+	int GetCornerTwist(int slot) const { return m_corners[slot] >> 3; }
+	int GetEdgePiece(int slot) const { return m_edges[slot] & 15; }
+	int GetEdgeFlip(int slot) const { return m_edges[slot] >> 4; }
+	int GetCenterPiece(int slot) const { return m_centers[slot] & 7; }
+	int GetCenterSpin(int slot) const { return m_centers[slot] >> 3; }
+
+	void SetCorner(int slot, int piece, int twist) { m_corners[slot] = static_cast<std::uint8_t>(piece | (twist << 3)); }
+	void SetEdge(int slot, int piece, int flip) { m_edges[slot] = static_cast<std::uint8_t>(piece | (flip << 4)); }
+	void SetCenter(int slot, int piece, int spin) { m_centers[slot] = static_cast<std::uint8_t>(piece | (spin << 3)); }
+
+	// rotation of the cubie at grid position (x, y, z) relative to its solved orientation,
+	// column major like glm: rotation[column][row]
+	void GetCubieRotation(int x, int y, int z, int rotation[3][3]) const;
+
+	static Move InverseMove(Move move) { return static_cast<Move>(move - move % 3 + 2 - move % 3); }
+	static const char* GetMoveName(Move move);
+
+	// move that turns the layer at grid coordinate layer (0..2) along axis (0 = x, 1 = y, 2 = z)
+	// by a quarter turn, counter clockwise around the positive axis for turnSign 1 and clockwise for -1
+	static Move FindLayerMove(int axis, int layer, int turnSign);
+
+private:
+	std::uint8_t m_corners[CORNER_COUNT]; // piece in bits 0-2, twist (0..2) in bits 3-4
+	std::uint8_t m_edges[EDGE_COUNT];     // piece in bits 0-3, flip (0..1) in bit 4
+	std::uint8_t m_centers[CENTER_COUNT]; // piece in bits 0-2, spin (0..3) in bits 3-4
+};
@@ -0,0 +1,126 @@
+#include "CubeSymmetry.h"
+#include "CubeMoveTables.h"
+
+namespace
+{
+	using namespace CubeMoveTables;
+
+	struct SymmetryTables
+	{
+		// where each slot ends up and which facet of that slot each of its facets is mapped to
+		int cornerSlot[CubeSymmetry::SYMMETRY_COUNT][CubeState::CORNER_COUNT];
+		int cornerFacet[CubeSymmetry::SYMMETRY_COUNT][CubeState::CORNER_COUNT][3];
+		int edgeSlot[CubeSymmetry::SYMMETRY_COUNT][CubeState::EDGE_COUNT];
+		int edgeFacet[CubeSymmetry::SYMMETRY_COUNT][CubeState::EDGE_COUNT][2];
+		int inverse[CubeSymmetry::SYMMETRY_COUNT];
+	};
+
+	struct SignedPermutation
+	{
+		int axis[3]; // result component i is sign[i] * v[axis[i]]
+		int sign[3];
+
+		IntVec Apply(const IntVec& v) const
+		{
+			return { sign[0] * Component(v, axis[0]), sign[1] * Component(v, axis[1]), sign[2] * Component(v, axis[2]) };
+		}
+	};
+
+	SymmetryTables BuildSymmetryTables()
+	{
+		const int AXIS_ORDERS[6][3] = { { 0, 1, 2 }, { 0, 2, 1 }, { 1, 0, 2 }, { 1, 2, 0 }, { 2, 0, 1 }, { 2, 1, 0 } };
+		SignedPermutation symmetries[CubeSymmetry::SYMMETRY_COUNT];
+		int count = 0;
+		for (int keepUD = 1; keepUD >= 0; --keepUD) // the symmetries that keep the y axis come first
+		{
+			for (const int* order : AXIS_ORDERS)
+			{
+				if ((order[1] == 1) != (keepUD == 1))
+					continue;
+				for (int signs = 0; signs < 8; ++signs)
+				{
+					SignedPermutation& symmetry = symmetries[count++];
+					for (int i = 0; i < 3; ++i)
+					{
+						symmetry.axis[i] = order[i];
+						symmetry.sign[i] = (signs >> i) & 1 ? -1 : 1;
+					}
+				}
+			}
+		}
+
+		SymmetryTables tables = {};
+		for (int s = 0; s < CubeSymmetry::SYMMETRY_COUNT; ++s)
+		{
+			const SignedPermutation& symmetry = symmetries[s];
+			for (int slot = 0; slot < CubeState::CORNER_COUNT; ++slot)
+			{
+				int to = FindCornerSlot(symmetry.Apply(CornerPosition(slot)));
+				tables.cornerSlot[s][slot] = to;
+				for (int facet = 0; facet < 3; ++facet)
+				{
+					int face = FindFace(symmetry.Apply(FACE_NORMALS[CORNER_FACETS[slot][facet]]));
+					int toFacet = 0;
+					while (CORNER_FACETS[to][toFacet] != face)
+						++toFacet;
+					tables.cornerFacet[s][slot][facet] = toFacet;
+				}
+			}
+			for (int slot = 0; slot < CubeState::EDGE_COUNT; ++slot)
+			{
+				int to = FindEdgeSlot(symmetry.Apply(EdgePosition(slot)));
+				tables.edgeSlot[s][slot] = to;
+				for (int facet = 0; facet < 2; ++facet)
+				{
+					int face = FindFace(symmetry.Apply(FACE_NORMALS[EDGE_FACETS[slot][facet]]));
+					tables.edgeFacet[s][slot][facet] = EDGE_FACETS[to][0] == face ? 0 : 1;
+				}
+			}
+
+			for (int other = 0; other < CubeSymmetry::SYMMETRY_COUNT; ++other) // the inverse matrix is the transpose
+			{
+				bool isInverse = true;
+				for (int i = 0; i < 3; ++i)
+					isInverse = isInverse && symmetries[other].axis[symmetry.axis[i]] == i
+						&& symmetries[other].sign[symmetry.axis[i]] == symmetry.sign[i];
+				if (isInverse)
+					tables.inverse[s] = other;
+			}
+		}
+		return tables;
+	}
+
+	const SymmetryTables& GetTables()
+	{
+		static const SymmetryTables tables = BuildSymmetryTables();
+		return tables;
+	}
+}
+
+CubeState CubeSymmetry::Conjugate(const CubeState& cube, int symmetry)
+{
+	// Every sticker moves to the image of its place and now belongs to the image of its home slot.
+	// Following the reference sticker of each piece is enough, the other stickers keep their order around it.
+	const SymmetryTables& tables = GetTables();
+	CubeState result;
+	for (int slot = 0; slot < CubeState::CORNER_COUNT; ++slot)
+	{
+		int piece = cube.GetCornerPiece(slot);
+		int facet = tables.cornerFacet[symmetry][slot][cube.GetCornerTwist(slot)];
+		int homeFacet = tables.cornerFacet[symmetry][piece][0];
+		result.SetCorner(tables.cornerSlot[symmetry][slot], tables.cornerSlot[symmetry][piece], (facet - homeFacet + 3) % 3);
+	}
+	for (int slot = 0; slot < CubeState::EDGE_COUNT; ++slot)
+	{
+		int piece = cube.GetEdgePiece(slot);
+		int facet = tables.edgeFacet[symmetry][slot][cube.GetEdgeFlip(slot)];
+		int homeFacet = tables.edgeFacet[symmetry][piece][0];
+		result.SetEdge(tables.edgeSlot[symmetry][slot], tables.edgeSlot[symmetry][piece], facet ^ homeFacet);
+	}
+	return result;
+}
+
+int CubeSymmetry::Inverse(int symmetry)
+{
+	return GetTables().inverse[symmetry];
+}
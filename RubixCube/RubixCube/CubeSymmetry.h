@@ -0,0 +1,16 @@
+#pragma once
+#include "CubeState.h"
+
+// The 48 symmetries of the cube (24 rotations, each with and without a mirror), generated from the signed
+// permutations of the three axes. Symmetry 0 is the identity and the first UD_SYMMETRY_COUNT keep the U-D axis in place.
+class CubeSymmetry
+{
+public:
+	static const int SYMMETRY_COUNT = 48;
+	static const int UD_SYMMETRY_COUNT = 16;
+
+	// The cube as seen after moving the whole puzzle by the symmetry, i.e. S * cube * S^-1. Mirrored symmetries
+	// give the mirror image of the scramble, which is a valid cube again. Centers are left solved.
+	static CubeState Conjugate(const CubeState& cube, int symmetry);
+	static int Inverse(int symmetry);
+};
@@ -0,0 +1,203 @@
+#include "CubeThumbnailRenderer.h"
+#include "PngWriter.h"
+#include <glm/glm.hpp>
+#include <glm/ext.hpp>
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <memory>
+
+bool CubeThumbnailRenderer::Initialize(int thumbnailSize, ThreadPool& pool)
+{
+	m_pool = &pool;
+	m_thumbnailSize = thumbnailSize;
+
+	GLint maxSize = 0, maxSamples = 0;
+	glGetIntegerv(GL_MAX_RENDERBUFFER_SIZE, &maxSize);
+	glGetIntegerv(GL_MAX_SAMPLES, &maxSamples);
+	m_columns = std::max(1, std::min(MAX_COLUMNS, maxSize / thumbnailSize));
+	m_atlasSize = m_columns * thumbnailSize;
+	int samples = std::min(4, static_cast<int>(maxSamples)); // smooth edges even in small images
+
+	glGenRenderbuffers(3, m_renderbuffers);
+	glBindRenderbuffer(GL_RENDERBUFFER, m_renderbuffers[0]);
+	glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, GL_RGBA8, m_atlasSize, m_atlasSize);
+	glBindRenderbuffer(GL_RENDERBUFFER, m_renderbuffers[1]);
+	glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, GL_DEPTH_COMPONENT24, m_atlasSize, m_atlasSize);
+	glBindRenderbuffer(GL_RENDERBUFFER, m_renderbuffers[2]);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, m_atlasSize, m_atlasSize);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	glGenFramebuffers(1, &m_multisampleFramebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_multisampleFramebuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_renderbuffers[0]);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, m_renderbuffers[1]);
+	bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+	glGenFramebuffers(1, &m_framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_renderbuffers[2]);
+	complete = complete && glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	if (!complete)
+	{
+		std::cerr << "Could not create a " << m_atlasSize << "x" << m_atlasSize << " framebuffer for the thumbnails" << std::endl;
+		return false;
+	}
+
+	std::size_t atlasBytes = static_cast<std::size_t>(m_atlasSize) * m_atlasSize * 4;
+	for (Readback& readback : m_readbacks)
+	{
+		glGenBuffers(1, &readback.buffer);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+		glBufferData(GL_PIXEL_PACK_BUFFER, atlasBytes, nullptr, GL_STREAM_READ);
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	m_sceneRenderer.Initialize(m_columns * m_columns);
+	m_camera.Initialize();
+
+	// the tiles lie in a plane facing the camera, so every cube is seen from the same direction
+	float halfTile = 0.9f * m_sceneRenderer.GetCubeExtension(); // the corners of the cube just fit in
+	float distance = 4.0f * halfTile;
+	glm::mat4 view = glm::lookAt(distance * glm::normalize(glm::vec3(1.0f, 1.2f, 1.6f)), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	glm::mat3 viewToWorld = glm::transpose(glm::mat3(view));
+	float halfAtlas = m_columns * halfTile;
+	m_camera.Update(glm::ortho(-halfAtlas, halfAtlas, -halfAtlas, halfAtlas, 0.1f, 2.0f * distance) * view);
+
+	m_tilePositions.clear();
+	for (int row = 0; row < m_columns; ++row)
+		for (int column = 0; column < m_columns; ++column)
+			m_tilePositions.push_back(viewToWorld * glm::vec3((2 * column + 1) * halfTile - halfAtlas, halfAtlas - (2 * row + 1) * halfTile, 0.0f));
+	return true;
+}
+
+void CubeThumbnailRenderer::Render(const CubeState* cubes, const std::string* fileNames, int count)
+{
+	int tilesPerAtlas = m_columns * m_columns;
+	for (int first = 0; first < count; first += tilesPerAtlas)
+	{
+		int tileCount = std::min(tilesPerAtlas, count - first);
+		Readback& readback = m_readbacks[m_nextReadback];
+		m_nextReadback = (m_nextReadback + 1) % READBACK_COUNT;
+		if (readback.fence != nullptr) // the atlas before the previous one
+			EncodeReadback(readback);
+
+		glBindFramebuffer(GL_FRAMEBUFFER, m_multisampleFramebuffer);
+		glViewport(0, 0, m_atlasSize, m_atlasSize);
+		glEnable(GL_DEPTH_TEST);
+		glDepthFunc(GL_LEQUAL);
+		glClearColor(0.0f, 0.0f, 0.0f, 0.0f); // transparent around the cubes
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		m_camera.Bind();
+		m_sceneRenderer.Render(cubes + first, m_tilePositions.data(), tileCount);
+
+		readback.fileNames.assign(fileNames + first, fileNames + first + tileCount);
+		StartReadback(readback);
+	}
+}
+
+int CubeThumbnailRenderer::Finish()
+{
+	for (int i = 0; i < READBACK_COUNT; ++i) // oldest first
+	{
+		Readback& readback = m_readbacks[(m_nextReadback + i) % READBACK_COUNT];
+		if (readback.fence != nullptr)
+			EncodeReadback(readback);
+	}
+	m_pool->Wait();
+	std::unique_lock<std::mutex> lock(m_encodingMutex); // a worker may still be destroying the last task
+	m_atlasReleased.wait(lock, [this] { return m_encodingAtlases == 0; });
+	return m_failedCount.exchange(0);
+}
+
+void CubeThumbnailRenderer::StartReadback(Readback& readback)
+{
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, m_multisampleFramebuffer);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_framebuffer);
+	glBlitFramebuffer(0, 0, m_atlasSize, m_atlasSize, 0, 0, m_atlasSize, m_atlasSize, GL_COLOR_BUFFER_BIT, GL_NEAREST); // resolves the samples
+
+	// into the buffer object, so the call returns at once and the copy happens when the GPU gets there
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, m_framebuffer);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+	glPixelStorei(GL_PACK_ALIGNMENT, 4);
+	glReadPixels(0, 0, m_atlasSize, m_atlasSize, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	readback.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	glFlush(); // the fence has to reach the GPU before anyone waits for it
+}
+
+void CubeThumbnailRenderer::EncodeReadback(Readback& readback)
+{
+	glClientWaitSync(readback.fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+	glDeleteSync(readback.fence);
+	readback.fence = nullptr;
+
+	{
+		std::unique_lock<std::mutex> lock(m_encodingMutex);
+		m_atlasReleased.wait(lock, [this] { return m_encodingAtlases < MAX_ENCODING_ATLASES; });
+		++m_encodingAtlases;
+	}
+
+	// copied out, so the buffer is free for the next atlas while the workers still encode; the last tile task
+	// holding the copy releases it
+	std::size_t rowSize = static_cast<std::size_t>(m_atlasSize) * 4;
+	std::shared_ptr<std::vector<std::uint8_t>> pixels(new std::vector<std::uint8_t>(rowSize * m_atlasSize),
+		[this](std::vector<std::uint8_t>* atlas) { ReleaseAtlas(atlas); });
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+	const void* mapped = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, pixels->size(), GL_MAP_READ_BIT);
+	if (mapped != nullptr)
+	{
+		std::memcpy(pixels->data(), mapped, pixels->size());
+		glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	if (mapped == nullptr)
+	{
+		m_failedCount += static_cast<int>(readback.fileNames.size());
+		readback.fileNames.clear();
+		return;
+	}
+
+	for (std::size_t tile = 0; tile < readback.fileNames.size(); ++tile)
+	{
+		// OpenGL rows go bottom up: the top row of the tile comes last in memory and the stride is negative
+		int column = static_cast<int>(tile) % m_columns;
+		int row = static_cast<int>(tile) / m_columns;
+		std::size_t topRow = static_cast<std::size_t>(m_atlasSize - 1 - row * m_thumbnailSize);
+		std::size_t offset = topRow * rowSize + static_cast<std::size_t>(column) * m_thumbnailSize * 4;
+		m_pool->Submit([this, pixels, offset, rowSize, fileName = std::move(readback.fileNames[tile])]()
+		{
+			if (!PngWriter::Write(fileName.c_str(), m_thumbnailSize, m_thumbnailSize, pixels->data() + offset, -static_cast<std::ptrdiff_t>(rowSize)))
+				++m_failedCount;
+		});
+	}
+	readback.fileNames.clear();
+}
+
+void CubeThumbnailRenderer::ReleaseAtlas(std::vector<std::uint8_t>* pixels)
+{
+	delete pixels;
+	{
+		std::lock_guard<std::mutex> lock(m_encodingMutex);
+		--m_encodingAtlases;
+	}
+	m_atlasReleased.notify_one();
+}
+
+void CubeThumbnailRenderer::ClearResources()
+{
+	for (Readback& readback : m_readbacks)
+	{
+		if (readback.fence != nullptr)
+			glDeleteSync(readback.fence);
+		readback.fence = nullptr;
+		glDeleteBuffers(1, &readback.buffer);
+	}
+	glDeleteFramebuffers(1, &m_framebuffer);
+	glDeleteFramebuffers(1, &m_multisampleFramebuffer);
+	glDeleteRenderbuffers(3, m_renderbuffers);
+	m_camera.ClearResources();
+	m_sceneRenderer.ClearResources();
+}
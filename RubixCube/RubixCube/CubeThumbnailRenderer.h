@@ -0,0 +1,65 @@
+#pragma once
+#include "CameraUniforms.h"
+#include "CubeSceneRenderer.h"
+#include "CubeState.h"
+#include "ThreadPool.h"
+#include <GL/glew.h>
+#include <glm/vec3.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Renders cube states into PNG files with an offscreen framebuffer, nothing is shown on screen. The states are drawn
+// as the tiles of an atlas, one instanced draw call per atlas, looked at orthographically from the front upper right
+// corner. An atlas is read back through a pixel buffer object while the next one is drawn, and its tiles are encoded
+// by the workers of a thread pool. At most MAX_ENCODING_ATLASES atlases wait for their encoding, beyond that drawing
+// waits for the workers, so the memory does not grow with the input when encoding is slower than drawing.
+// Needs a current OpenGL context, e.g. of a hidden window.
+class CubeThumbnailRenderer
+{
+public:
+	static const int MAX_COLUMNS = 16;  // tiles per row and column of an atlas
+	static const int READBACK_COUNT = 2;
+	static const int MAX_ENCODING_ATLASES = 4; // copies of read back atlases, 16 MiB each with 128 pixel tiles
+
+	// returns false if the framebuffer can not be created
+	bool Initialize(int thumbnailSize, ThreadPool& pool);
+	// queues the images of the states; the one of cubes[i] is written to fileNames[i]
+	void Render(const CubeState* cubes, const std::string* fileNames, int count);
+	// waits until all queued images are written and returns how many of them could not be written
+	int Finish();
+	void ClearResources();
+
+private:
+	struct Readback
+	{
+		GLuint buffer = 0;          // pixel buffer object
+		GLsync fence = nullptr;     // signaled when the pixels have arrived in the buffer; null while unused
+		std::vector<std::string> fileNames; // of the tiles in order
+	};
+
+	void StartReadback(Readback& readback);
+	void EncodeReadback(Readback& readback); // waits for the pixels and hands them to the pool
+	void ReleaseAtlas(std::vector<std::uint8_t>* pixels); // after the last tile of an atlas is encoded
+
+	ThreadPool* m_pool = nullptr;
+	CubeSceneRenderer m_sceneRenderer;
+	CameraUniforms m_camera;
+	int m_thumbnailSize = 0;
+	int m_columns = 0;
+	int m_atlasSize = 0;                     // in pixels, both directions
+	std::vector<glm::vec3> m_tilePositions;  // cube centers, row by row from the top left
+
+	GLuint m_multisampleFramebuffer = 0;     // drawn into, resolved into m_framebuffer
+	GLuint m_framebuffer = 0;
+	GLuint m_renderbuffers[3] = {};          // multisampled color and depth, resolved color
+	Readback m_readbacks[READBACK_COUNT];
+	int m_nextReadback = 0;
+	std::atomic<int> m_failedCount{ 0 };
+
+	std::mutex m_encodingMutex;
+	std::condition_variable m_atlasReleased;
+	int m_encodingAtlases = 0; // guarded by m_encodingMutex
+};
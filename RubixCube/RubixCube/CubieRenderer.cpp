@@ -1,113 +1,190 @@
 #include "CubieRenderer.h"
+#include "CameraUniforms.h"
+#include "ShaderManager.h"
 #include "ShaderUtil.h"
+#include <glm/gtc/packing.hpp>
 #include <glm/gtc/type_ptr.hpp>
+#include <cstddef>
 
-void CubieRenderer::Initialize()
+const float CubieRenderer::FACE_COLORS[6][3] = {
+	{ 1.0f, 1.0f, 1.0f }, { 1.0f, 0.5f, 0.0f }, { 0.0f, 0.0f, 1.0f }, { 1.0f, 1.0f, 0.0f }, { 1.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f } };
+
+void CubieRenderer::Initialize(ShaderManager* shaders)
+{
+	InitializeMesh();
+
+	auto setProgram = [this](GLuint program)
+	{
+		m_shaderProgram = program;
+		m_modelLocation = glGetUniformLocation(m_shaderProgram, "model");                                    // Get uniform location for model matrix
+		CameraUniforms::BindBlock(m_shaderProgram);                                                          // view and projection come from the camera buffer
+	};
+	if (shaders != nullptr)
+		setProgram(shaders->Load("VertexShaderColor.glsl", "FragmentShaderColor.glsl", setProgram));
+	else
+		setProgram(ShaderUtil::CreateShaderProgram("VertexShaderColor.glsl", "FragmentShaderColor.glsl")); // Create shader program from files
+
+	glGenVertexArrays(1, &m_arrayBufferObject);               // filled with information of the vertex buffer objects and how their contents map on the input parameters of the vertex shader
+	glBindVertexArray(m_arrayBufferObject);					  // Bind the VAO
+	BindMesh();                                               // Describe vertex attributes 0 (position) and 1 (color)
+	glBindVertexArray(0);                                     // Unbind VAO
+
+	// instanced drawing: the same cube mesh, the transform of every cubie comes from a per instance attribute
+	auto setInstancedProgram = [this](GLuint program)
+	{
+		m_instancedShaderProgram = program;
+		m_instancedModelLocation = glGetUniformLocation(m_instancedShaderProgram, "model");
+		CameraUniforms::BindBlock(m_instancedShaderProgram);
+	};
+	if (shaders != nullptr)
+		setInstancedProgram(shaders->Load("VertexShaderInstanced.glsl", "FragmentShaderColor.glsl", setInstancedProgram));
+	else
+		setInstancedProgram(ShaderUtil::CreateShaderProgram("VertexShaderInstanced.glsl", "FragmentShaderColor.glsl"));
+
+	glGenVertexArrays(1, &m_instancedArrayObject);
+	glGenBuffers(1, &m_instanceBufferObject);
+	glBindVertexArray(m_instancedArrayObject);
+
+	BindMesh();                                               // the attributes 0 and 1 read the buffers filled above
+
+	glBindBuffer(GL_ARRAY_BUFFER, m_instanceBufferObject);
+	for (int column = 0; column < 4; ++column)                // a mat4 attribute takes one location per column
+	{
+		glVertexAttribPointer(2 + column, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), reinterpret_cast<void*>(column * sizeof(glm::vec4)));
+		glEnableVertexAttribArray(2 + column);
+		glVertexAttribDivisor(2 + column, 1);                 // advance once per cubie instead of once per vertex
+	}
+
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindVertexArray(0);
+}
+
+void CubieRenderer::InitializeMesh()
 {
-	float floatArray[6 * 6 * 3]; // target array; 6 cube faces, 6 vertices, each vertex has 3 floats
-	std::vector<glm::vec3> positionField;
-	std::vector<glm::vec3> colorField;
+	Vertex vertices[VERTEX_COUNT];   // 24 unique corners: every face has its own color
+	GLubyte indices[INDEX_COUNT];    // two triangles per face
 
 	// Build the cube information.
+	int side = 0;
 	for (int sideType = 0; sideType < 3; ++sideType)
 	{
 		for (int direction = -1; direction < 2; direction += 2)
 		{
-			AddSidePosition(sideType, direction, positionField);      // Add vertex positions for each cube face side
-			AddSideColor(sideType, direction, colorField);            // Add colors for each cube face side
+			AddSide(sideType, direction, &vertices[4 * side], &indices[6 * side], 4 * side); // Add vertices and triangles for each cube face side
+			++side;
 		}
 	}
 
-	m_shaderProgram = ShaderUtil::CreateShaderProgram("VertexShaderColor.glsl", "FragmentShaderColor.glsl"); // Create shader program from files
-	m_transformLocation = glGetUniformLocation(m_shaderProgram, "transformation");                           // Get uniform location for transformation matrix
-
-	glGenVertexArrays(1, &m_arrayBufferObject);               // filled with information of both vertex buffer objects and how their contents map on the input parameters of the vertex shader
 	glGenBuffers(2, m_vertexBufferObject);                    // Generate two VBOs (Vertex Buffer Objects)
 
-	glBindVertexArray(m_arrayBufferObject);					  // Bind the VAO
-
-	glBindBuffer(GL_ARRAY_BUFFER, m_vertexBufferObject[0]);   // Bind first VBO (positions)
-	TranscribeToFloatArray(positionField, floatArray);        // Convert vector data to float array
-	glBufferData(GL_ARRAY_BUFFER, sizeof(floatArray), floatArray, GL_STATIC_DRAW); // Upload position data to GPU buffer
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), static_cast<void*>(0)); // Describe vertex attribute 0 (position)
-	glEnableVertexAttribArray(0);                             // Enable vertex attribute 0
-
-	glBindBuffer(GL_ARRAY_BUFFER, m_vertexBufferObject[1]);   // Bind second VBO (colors)
-	TranscribeToFloatArray(colorField, floatArray);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(floatArray), floatArray, GL_STATIC_DRAW);
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), static_cast<void*>(0)); // Describe vertex attribute 1 (color)
-	glEnableVertexAttribArray(1);                             // Enable vertex attribute 1
-
-	glBindBuffer(GL_ARRAY_BUFFER, 0);                         // Unbind any buffer
-	glBindVertexArray(0);                                     // Unbind VAO
+	glBindBuffer(GL_ARRAY_BUFFER, m_vertexBufferObject[0]);   // Upload the interleaved vertices
+	glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, m_vertexBufferObject[1]); // Upload the indices; not as element buffer, no VAO is bound yet
+	glBufferData(GL_COPY_WRITE_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
 }
 
-void CubieRenderer::Render(const glm::mat4& transformationMatrix)
+void CubieRenderer::Render(const glm::mat4& modelMatrix)
 {
 	glUseProgram(m_shaderProgram);                            // Use the compiled shader program
 	glBindVertexArray(m_arrayBufferObject);                   // Bind VAO for drawing
 
-	glUniformMatrix4fv(m_transformLocation, 1, GL_FALSE, value_ptr(transformationMatrix)); // Upload transformation matrix uniform
-	glDrawArrays(GL_TRIANGLES, 0, 6 * 6);                     // draw 36 verticies
+	glUniformMatrix4fv(m_modelLocation, 1, GL_FALSE, value_ptr(modelMatrix)); // Upload model matrix uniform
+	glDrawElements(GL_TRIANGLES, INDEX_COUNT, INDEX_TYPE, nullptr); // draw 12 triangles
 
 	glBindVertexArray(0);                                     // Unbind VAO
 	glUseProgram(0);                                          // Unbind shader program
 }
 
+void CubieRenderer::BindMesh() const
+{
+	glBindBuffer(GL_ARRAY_BUFFER, m_vertexBufferObject[0]);
+	glVertexAttribPointer(0, 3, GL_HALF_FLOAT, GL_FALSE, sizeof(Vertex), reinterpret_cast<void*>(offsetof(Vertex, position)));
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(1, 3, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(Vertex), reinterpret_cast<void*>(offsetof(Vertex, color)));
+	glEnableVertexAttribArray(1);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_vertexBufferObject[1]); // part of the vertex array object, so it stays bound
+}
+
+void CubieRenderer::RenderInstanced(const glm::mat4& modelMatrix, const glm::mat4* cubieTransforms, int count)
+{
+	glBindBuffer(GL_ARRAY_BUFFER, m_instanceBufferObject);   // a new data store each frame, the driver need not wait for the last one
+	glBufferData(GL_ARRAY_BUFFER, count * sizeof(glm::mat4), cubieTransforms, GL_STREAM_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	m_instanceCapacity = count;
+
+	DrawInstances(modelMatrix, count);
+}
+
+void CubieRenderer::UpdateInstances(const glm::mat4* cubieTransforms, int first, int count)
+{
+	glBindBuffer(GL_ARRAY_BUFFER, m_instanceBufferObject);
+	if (first + count > m_instanceCapacity)                  // growing drops the instances uploaded before
+	{
+		glBufferData(GL_ARRAY_BUFFER, (first + count) * sizeof(glm::mat4), nullptr, GL_DYNAMIC_DRAW);
+		m_instanceCapacity = first + count;
+	}
+	glBufferSubData(GL_ARRAY_BUFFER, first * sizeof(glm::mat4), count * sizeof(glm::mat4), cubieTransforms + first);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void CubieRenderer::DrawInstances(const glm::mat4& modelMatrix, int count)
+{
+	glUseProgram(m_instancedShaderProgram);
+	glBindVertexArray(m_instancedArrayObject);
+
+	glUniformMatrix4fv(m_instancedModelLocation, 1, GL_FALSE, value_ptr(modelMatrix));
+	glDrawElementsInstanced(GL_TRIANGLES, INDEX_COUNT, INDEX_TYPE, nullptr, count); // all cubies in one draw call
+
+	glBindVertexArray(0);
+	glUseProgram(0);
+}
+
 void CubieRenderer::ClearResources()
 {
-	glDeleteBuffers(2, m_vertexBufferObject);                 // Delete the two vertex buffer objects
+	glDeleteBuffers(1, &m_instanceBufferObject);
+	glDeleteVertexArrays(1, &m_instancedArrayObject);
+	glDeleteProgram(m_instancedShaderProgram);
+	glDeleteBuffers(2, m_vertexBufferObject);                 // Delete the vertex and index buffer objects
 	glDeleteVertexArrays(1, &m_arrayBufferObject);            // Delete the VAO
 	glDeleteProgram(m_shaderProgram);                         // Delete the shader program
 }
 
-void CubieRenderer::AddSidePosition(int sideType, int direction, std::vector<glm::vec3>& positionArray)
+void CubieRenderer::AddSide(int sideType, int direction, Vertex* vertices, GLubyte* indices, int firstVertex)
 {
-	glm::vec3 cornerPoints[2][2];                             // 4 corner points for a face (2x2 grid)
-
 	int localXDim = (sideType + 1) % 3;                       // Determine local X axis (other than sideType)
 	int localYDim = (sideType + 2) % 3;						  // Determine local Y axis
+	glm::vec3 color = GetSideColor(sideType, direction);
 
-	for (int i = 0; i < 2; ++i)
+	// the corners go counter clockwise around the local axes, whose cross product points along the positive axis
+	const int corners[4][2] = { { 0, 0 }, { 1, 0 }, { 1, 1 }, { 0, 1 } };
+	for (int corner = 0; corner < 4; ++corner)
 	{
-		for (int j = 0; j < 2; ++j)
+		glm::vec3 localPoint(direction * m_offset);           // Start with fixed offset along sideType axis
+		localPoint[localXDim] = (2 * corners[corner][0] - 1) * m_offset; // Set local X coordinate to -offset or offset
+		localPoint[localYDim] = (2 * corners[corner][1] - 1) * m_offset; // Set local Y coordinate to -offset or offset
+
+		Vertex& vertex = vertices[corner];
+		for (int coord = 0; coord < 3; ++coord)
 		{
-			glm::vec3 localPoint(direction * m_offset);       // Start with fixed offset along sideType axis
-			localPoint[localXDim] = (2 * i - 1) * m_offset;   // Set local X coordinate to -offset or offset
-			localPoint[localYDim] = (2 * j - 1) * m_offset;   // Set local Y coordinate to -offset or offset
-			cornerPoints[i][j] = localPoint;                  // Store corner point
+			vertex.position[coord] = glm::packHalf1x16(localPoint[coord]); // 0.5 is exact as half float
+			vertex.color[coord] = static_cast<std::uint8_t>(color[coord] * 255.0f + 0.5f);
 		}
+		vertex.position[3] = 0;
+		vertex.color[3] = 255;
 	}
 
-	// Create two triangles from the 4 corners (6 vertices)
-	positionArray.push_back(cornerPoints[0][0]);
-	positionArray.push_back(cornerPoints[1][0]);
-	positionArray.push_back(cornerPoints[0][1]);
-	positionArray.push_back(cornerPoints[1][0]);
-	positionArray.push_back(cornerPoints[0][1]);
-	positionArray.push_back(cornerPoints[1][1]);
-}
-
-void CubieRenderer::AddSideColor(int sideType, int direction, std::vector<glm::vec3>& colorArray)
-{
-	glm::vec3 color;
-
-	// Classic Rubik's Cube colors
-	if (sideType == 0)                                         // X axis
-		color = (direction == 1) ? glm::vec3(1.0f, 0.5f, 0.0f) : glm::vec3(1.0f, 0.0f, 0.0f); // Orange & Red
-	else if (sideType == 1)                                    // Y axis
-		color = (direction == 1) ? glm::vec3(1.0f, 1.0f, 1.0f) : glm::vec3(1.0f, 1.0f, 0.0f); // White & Yellow
-	else if (sideType == 2)                                    // Z axis
-		color = (direction == 1) ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f); // Blue & Green
-
+	// Create two triangles from the 4 corners, both counter clockwise as seen from outside
+	const GLubyte triangles[6] = { 0, 1, 2, 0, 2, 3 };
 	for (int i = 0; i < 6; ++i)
-		colorArray.push_back(color);                           // Add the same color for all 6 vertices of the face
+		indices[i] = static_cast<GLubyte>(firstVertex + (direction == 1 ? triangles[i] : triangles[5 - i]));
 }
 
-void CubieRenderer::TranscribeToFloatArray(std::vector<glm::vec3>& vecArray, float* floatArray)
+glm::vec3 CubieRenderer::GetSideColor(int sideType, int direction) const
 {
-	int writingCounter = 0;
-	for (int i = 0; i < 36; ++i)                               // For all 36 vertices
-		for (int coord = 0; coord < 3; ++coord)                // For each coordinate (x,y,z)
-			floatArray[writingCounter++] = vecArray[i][coord]; // Copy float values sequentially into the flat array
+	const int faces[2][3] = { { 4, 3, 5 }, { 1, 0, 2 } };     // L D B along the negative axes, R U F along the positive ones
+	const float* color = FACE_COLORS[faces[direction == 1 ? 1 : 0][sideType]];
+	return glm::vec3(color[0], color[1], color[2]);
 }
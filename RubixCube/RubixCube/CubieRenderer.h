@@ -1,28 +1,58 @@
 #pragma once
 #include <glm/mat4x4.hpp>
 #include <GL/glew.h>
-#include <vector>
+#include <cstdint>
+
+class ShaderManager;
 
 class CubieRenderer
 {
 public:
-	void Initialize();
-	void Render(const glm::mat4& transformationMatrix); // when rendered, the center point is used
+	void Initialize(ShaderManager* shaders = nullptr); // with a shader manager, the programs are reloaded when their files change
+	// only the vertex and index buffers for BindMesh, without shader programs or vertex array objects of its own
+	void InitializeMesh();
+	// the view and projection come from the Camera uniform block, see CameraUniforms
+	void Render(const glm::mat4& modelMatrix); // when rendered, the center point is used
+	// draws count cubies with one draw call; every cubie transform is applied before the shared model matrix
+	void RenderInstanced(const glm::mat4& modelMatrix, const glm::mat4* cubieTransforms, int count);
+	// the same, but the cubie transforms stay in the instance buffer between frames and only changed ones are uploaded:
+	// UpdateInstances uploads cubieTransforms[first, first + count), DrawInstances draws the first count instances
+	void UpdateInstances(const glm::mat4* cubieTransforms, int first, int count);
+	void DrawInstances(const glm::mat4& modelMatrix, int count);
 	void ClearResources();
 
+	// binds the cubie mesh to the attributes 0 (position) and 1 (color) and its index buffer to the currently bound
+	// vertex array object; draw it with INDEX_COUNT indices of type INDEX_TYPE
+	void BindMesh() const;
+	static const int VERTEX_COUNT = 6 * 4;
+	static const int INDEX_COUNT = 6 * 6;
+	static const GLenum INDEX_TYPE = GL_UNSIGNED_BYTE;
+	static const float FACE_COLORS[6][3]; // classic colors in the face order of CubeState: U R F D L B
+
 	float GetCubieExtension() const { return 2.0f * m_offset; }
 
 private:
 	const float m_offset = 0.5f; // half the size of the cube
 
+	struct Vertex // 12 bytes, interleaved
+	{
+		std::uint16_t position[4]; // half floats, the fourth only pads to 4 byte alignment
+		std::uint8_t color[4];     // normalized, the fourth is unused
+	};
+
 	// sideType: 0 perpendicular to the x-axis, 1 to y, 2 to z; direction 1 or -1
-	void AddSidePosition(int sideType, int direction, std::vector<glm::vec3>& positionArray); // store vertex positions in positionArray
-	void AddSideColor(int sideType, int direction, std::vector<glm::vec3>& colorArray);
-	void TranscribeToFloatArray(std::vector<glm::vec3>& vecArray, float* floatArray); // vec to float array
+	void AddSide(int sideType, int direction, Vertex* vertices, GLubyte* indices, int firstVertex); // 4 vertices and 6 indices
+	glm::vec3 GetSideColor(int sideType, int direction) const;
+
 
+	GLuint m_arrayBufferObject = 0;
+	GLuint m_vertexBufferObject[2] = {}; // objects for the vertices and the indices
+	GLuint m_shaderProgram = 0;
+	GLint m_modelLocation;
 
-	GLuint m_arrayBufferObject;
-	GLuint m_vertexBufferObject[2]; // objects for position and color
-	GLuint m_shaderProgram;
-	GLint m_transformLocation;
+	GLuint m_instancedArrayObject = 0; // the same vertex buffers plus the instance buffer
+	GLuint m_instanceBufferObject = 0; // one cubie transform per instance
+	int m_instanceCapacity = 0;        // instances the buffer has room for
+	GLuint m_instancedShaderProgram = 0;
+	GLint m_instancedModelLocation;
 };
\ No newline at end of file
@@ -0,0 +1,39 @@
+# Embeds the GLSL files next to this script into ShaderSources.h as raw string literals, see ShaderUtil.
+# Runs before every build of the projects that use the shaders; the header is only rewritten when a shader changed,
+# so unchanged shaders do not cause a recompile. ShaderUtil.cpp checks the embedded sources at compile time.
+$directory = $PSScriptRoot
+$bytes = [Text.Encoding]::GetEncoding(28591) # Latin-1 keeps every byte as it is, whatever the comments are encoded in
+$lines = @(
+    '#pragma once',
+    '#include <string_view>',
+    '',
+    '// Generated by EmbedShaders.ps1 from the *.glsl files before every build, do not edit.',
+    'namespace ShaderSources',
+    '{',
+    "`tstruct Source",
+    "`t{",
+    "`t`tstd::string_view fileName;",
+    "`t`tstd::string_view text;",
+    "`t};",
+    '',
+    "`tconstexpr Source ALL[] =",
+    "`t{"
+)
+foreach ($file in Get-ChildItem -Path $directory -Filter *.glsl | Sort-Object Name)
+{
+    $text = [IO.File]::ReadAllText($file.FullName, $bytes) -replace "`r`n", "`n"
+    if ($text.Contains(')glsl"'))
+    {
+        Write-Error "$($file.Name) contains the raw string delimiter )glsl`""
+        exit 1
+    }
+    $lines += "`t`t{ `"$($file.Name)`", R`"glsl($text)glsl`" },"
+}
+$lines += @("`t};", '}', '')
+$content = $lines -join "`n"
+
+$target = Join-Path $directory 'ShaderSources.h'
+if (!(Test-Path $target) -or [IO.File]::ReadAllText($target, $bytes) -ne $content)
+{
+    [IO.File]::WriteAllText($target, $content, $bytes)
+}
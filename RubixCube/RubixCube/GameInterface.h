@@ -9,6 +9,21 @@ public:
 
 	virtual void Update(double deltaTime) {}
 	virtual void Render(float aspectRatio) {}
+	// interpolation from 0 to 1 blends the state before the last Update into the state after it
+	virtual void Render(float aspectRatio, double interpolation) { Render(aspectRatio); }
+	virtual bool IsAnimating() const { return true; } // false while the picture only changes on input
+
+	// for rendering on a thread of its own: Publish runs on the update thread after the updates of a frame and hands
+	// their result, reached at the given time, over to RenderPublished, which draws it on the render thread
+	virtual bool SupportsRenderThread() const { return false; }
+	virtual void Publish(double time) {}
+	virtual void RenderPublished(float aspectRatio, double time) { Render(aspectRatio); }
+
+	// input log of every Update for a deterministic replay; GetReplayStep is the delta time the next Update of a
+	// replay has to get, negative when the replay is over
+	virtual bool StartRecording(const char* fileName) { return false; }
+	virtual bool StartReplay(const char* fileName) { return false; }
+	virtual double GetReplayStep() const { return -1.0; }
 
 	virtual void ClearResources() {}
 };
\ No newline at end of file
@@ -1,13 +1,226 @@
 #include "InputSystem.h"
+#include <GLFW/glfw3.h>
+#include <algorithm>
+#include <cstring>
+#include <iostream>
 
-void InputSystem::Update()
+static_assert(InputSystem::KEY_COUNT == GLFW_KEY_LAST + 1, "one state per GLFW key code");
+
+std::vector<InputSystem*> InputSystem::s_instances;
+GLFWkeyfun InputSystem::s_previousCallback = nullptr;
+
+// input log: the header, then one record per update, all little endian
+//   header: "RCIN", uint16 version
+//   record: uint16 event count, with NEW_STEP set followed by the float64 delta time, else it is that of the record before
+//   event:  uint16 key, uint8 action, float32 seconds since the recording started
+static const char LOG_MAGIC[4] = { 'R', 'C', 'I', 'N' };
+static const std::uint16_t LOG_VERSION = 1;
+static const std::uint16_t NEW_STEP = 0x8000;
+
+static void WriteBytes(std::ostream& stream, std::uint64_t value, int byteCount)
+{
+	char bytes[8];
+	for (int i = 0; i < byteCount; ++i)
+		bytes[i] = static_cast<char>(value >> (8 * i));
+	stream.write(bytes, byteCount);
+}
+
+static std::uint64_t ReadBytes(std::istream& stream, int byteCount)
+{
+	unsigned char bytes[8] = {};
+	stream.read(reinterpret_cast<char*>(bytes), byteCount);
+	std::uint64_t value = 0;
+	for (int i = 0; i < byteCount; ++i)
+		value |= std::uint64_t(bytes[i]) << (8 * i);
+	return value;
+}
+
+InputSystem::~InputSystem()
+{
+	s_instances.erase(std::remove(s_instances.begin(), s_instances.end(), this), s_instances.end());
+}
+
+void InputSystem::SetWindow(GLFWwindow* window)
 {
-	for (auto i = m_keyMapper.begin(); i != m_keyMapper.end(); ++i)
-		i->second.Update();
+	m_window = window;
+	if (std::find(s_instances.begin(), s_instances.end(), this) == s_instances.end())
+		s_instances.push_back(this);
+
+	GLFWkeyfun previous = glfwSetKeyCallback(window, OnKey);
+	if (previous != OnKey) // another input system may have installed it already
+		s_previousCallback = previous;
+}
+
+void InputSystem::Update(double deltaTime)
+{
+	for (int key : m_observedKeys)
+		m_keys[key] &= ~(PRESSED | RELEASED);
+
+	m_appliedEvents.clear();
+	if (IsReplaying())
+	{
+		ReadReplayEvents();
+		ReadReplayRecordHeader();
+	}
+	else if (m_eventsLost) // too many events to replay them, at least the keys end up in the right state
+	{
+		double time = glfwGetTime();
+		for (int key : m_observedKeys)
+		{
+			bool isDown = glfwGetKey(m_window, key) == GLFW_PRESS;
+			if (isDown != ((m_keys[key] & DOWN) != 0))
+				m_appliedEvents.push_back({ key, isDown ? GLFW_PRESS : GLFW_RELEASE, time });
+		}
+		m_eventCount = 0;
+		m_eventsLost = false;
+	}
+	else
+	{
+		for (; m_eventCount > 0; --m_eventCount, m_firstEvent = (m_firstEvent + 1) % EVENT_CAPACITY)
+			m_appliedEvents.push_back(m_events[m_firstEvent]);
+	}
+
+	for (const KeyEvent& event : m_appliedEvents)
+		ApplyEvent(event);
+	if (m_recording.is_open())
+		WriteRecord(deltaTime);
+}
+
+void InputSystem::ApplyEvent(const KeyEvent& event)
+{
+	std::uint8_t& state = m_keys[event.key];
+	if (event.action == GLFW_PRESS && (state & DOWN) == 0)
+		state |= DOWN | PRESSED;
+	else if (event.action == GLFW_RELEASE && (state & DOWN) != 0)
+		state = (state & ~DOWN) | RELEASED;
 }
 
 void InputSystem::ObserveKey(int key)
 {
-	m_keyMapper[key] = KeyboardObserver(m_window, key);
+	if (key < 0 || key >= KEY_COUNT || (m_keys[key] & OBSERVED) != 0)
+		return;
+	m_keys[key] = OBSERVED;
+	m_observedKeys.push_back(key);
+}
+
+bool InputSystem::StartRecording(const std::string& fileName)
+{
+	m_recording.close();
+	m_recording.open(fileName, std::ios::binary | std::ios::trunc);
+	if (!m_recording)
+	{
+		std::cerr << "Failed to write input log " << fileName << std::endl;
+		return false;
+	}
+	m_recording.write(LOG_MAGIC, sizeof(LOG_MAGIC));
+	WriteBytes(m_recording, LOG_VERSION, 2);
+	m_recordingStart = glfwGetTime();
+	m_recordedStep = 0.0;
+	return true;
+}
+
+void InputSystem::StopRecording()
+{
+	m_recording.close();
+}
+
+bool InputSystem::StartReplay(const std::string& fileName)
+{
+	m_replayStep = -1.0;
+	m_replay.close();
+	m_replay.open(fileName, std::ios::binary);
+	char magic[sizeof(LOG_MAGIC)] = {};
+	m_replay.read(magic, sizeof(magic));
+	if (!m_replay || std::memcmp(magic, LOG_MAGIC, sizeof(magic)) != 0 || ReadBytes(m_replay, 2) != LOG_VERSION)
+	{
+		std::cerr << "No input log of version " << LOG_VERSION << ": " << fileName << std::endl;
+		m_replay.close();
+		return false;
+	}
+	m_replayStep = 0.0;
+	m_eventCount = 0; // the live events so far are not part of the replay
+	m_eventsLost = false;
+	ReadReplayRecordHeader();
+	return true;
+}
+
+void InputSystem::WriteRecord(double deltaTime)
+{
+	std::uint16_t count = static_cast<std::uint16_t>(std::min<std::size_t>(m_appliedEvents.size(), NEW_STEP - 1));
+	bool newStep = deltaTime != m_recordedStep;
+	WriteBytes(m_recording, count | (newStep ? NEW_STEP : 0), 2);
+	if (newStep)
+	{
+		std::uint64_t bits;
+		std::memcpy(&bits, &deltaTime, sizeof(bits));
+		WriteBytes(m_recording, bits, 8);
+		m_recordedStep = deltaTime;
+	}
+	for (std::uint16_t i = 0; i < count; ++i)
+	{
+		const KeyEvent& event = m_appliedEvents[i];
+		float time = static_cast<float>(event.time - m_recordingStart);
+		std::uint32_t bits;
+		std::memcpy(&bits, &time, sizeof(bits));
+		WriteBytes(m_recording, event.key, 2);
+		WriteBytes(m_recording, event.action, 1);
+		WriteBytes(m_recording, bits, 4);
+	}
 }
 
+void InputSystem::ReadReplayRecordHeader()
+{
+	std::uint16_t count = static_cast<std::uint16_t>(ReadBytes(m_replay, 2));
+	if (count & NEW_STEP)
+	{
+		std::uint64_t bits = ReadBytes(m_replay, 8);
+		std::memcpy(&m_replayStep, &bits, sizeof(bits));
+	}
+	m_replayEventCount = count & ~NEW_STEP;
+	if (!m_replay || m_replayStep < 0.0) // the end of the log
+	{
+		m_replayStep = -1.0;
+		m_replay.close();
+	}
+}
+
+void InputSystem::ReadReplayEvents()
+{
+	for (unsigned i = 0; i < m_replayEventCount; ++i)
+	{
+		KeyEvent event;
+		event.key = static_cast<int>(ReadBytes(m_replay, 2));
+		event.action = static_cast<int>(ReadBytes(m_replay, 1));
+		std::uint32_t bits = static_cast<std::uint32_t>(ReadBytes(m_replay, 4));
+		float time;
+		std::memcpy(&time, &bits, sizeof(time));
+		event.time = time;
+		if (m_replay && event.key < KEY_COUNT)
+			m_appliedEvents.push_back(event);
+	}
+}
+
+void InputSystem::QueueEvent(int key, int action)
+{
+	if (m_eventCount == EVENT_CAPACITY)
+	{
+		m_eventsLost = true;
+		return;
+	}
+	m_events[(m_firstEvent + m_eventCount) % EVENT_CAPACITY] = { key, action, glfwGetTime() };
+	++m_eventCount;
+}
+
+void InputSystem::OnKey(GLFWwindow* window, int key, int scancode, int action, int mods)
+{
+	if (key >= 0 && key < KEY_COUNT && action != GLFW_REPEAT)
+	{
+		for (InputSystem* input : s_instances)
+		{
+			if (input->m_window == window && (input->m_keys[key] & OBSERVED) != 0 && !input->IsReplaying()) // a replay only sees the log
+				input->QueueEvent(key, action);
+		}
+	}
+	if (s_previousCallback != nullptr)
+		s_previousCallback(window, key, scancode, action, mods);
+}
@@ -1,20 +1,85 @@
 #pragma once
-#include "KeyboardObserver.h"
-#include <map>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
 
+struct GLFWwindow;
+
+// Keyboard state built from GLFW key events instead of asking for every observed key each frame. The key callback
+// queues timestamped events in a ring buffer, Update applies them to a flat state per key code. A key pressed and
+// released between two updates counts as both pressed and released in the next one, so no press is lost at low
+// frame rates. The callback set on the window before is still called for every event.
+// A recording writes the delta time and the applied key events of every update into a binary log; a replay reads them
+// back instead of the window's events, so the same updates see the same input in the same order.
 class InputSystem
 {
 public:
-	InputSystem() { m_window = nullptr; }
-	void SetWindow(GLFWwindow* window) { m_window = window; }
-	void Update();
-	void ObserveKey(int key);
+	static const int KEY_COUNT = 349;      // GLFW_KEY_LAST + 1
+	static const int EVENT_CAPACITY = 256; // events between two updates; beyond that the states are read from GLFW
+
+	struct KeyEvent
+	{
+		int key;
+		int action;  // GLFW_PRESS or GLFW_RELEASE
+		double time; // glfwGetTime when the event arrived; seconds since the recording started in a replay
+	};
+
+	InputSystem() = default;
+	~InputSystem();
+	InputSystem(const InputSystem&) = delete;
+	InputSystem& operator=(const InputSystem&) = delete;
+
+	void SetWindow(GLFWwindow* window); // installs the key callback
+	void Update(double deltaTime = 0.0); // applies the events since the last update; deltaTime is only recorded
+	void ObserveKey(int key); // events of other keys are ignored
+
+	bool StartRecording(const std::string& fileName); // false if the file can not be written
+	void StopRecording();
+	bool IsRecording() const { return m_recording.is_open(); }
+	bool StartReplay(const std::string& fileName);    // false if the file is no input log
+	bool IsReplaying() const { return m_replayStep >= 0.0; }
+	double GetReplayStep() const { return m_replayStep; } // delta time of the next replayed update, negative at the end
 
-	bool IsKeyDown(int key) { return m_keyMapper[key].m_isDown; }
-	bool WasKeyPressed(int key) { return m_keyMapper[key].m_wasPressed; }
-	bool WasKeyReleased(int key) { return m_keyMapper[key].m_wasReleased; }
+	bool IsKeyDown(int key) const { return HasState(key, DOWN); }
+	bool WasKeyPressed(int key) const { return HasState(key, PRESSED); }
+	bool WasKeyReleased(int key) const { return HasState(key, RELEASED); }
 
 private:
-	std::map<int, KeyboardObserver> m_keyMapper;
-	GLFWwindow* m_window;
-};
\ No newline at end of file
+	enum KeyState : std::uint8_t
+	{
+		DOWN = 1,
+		PRESSED = 2,  // in the last update
+		RELEASED = 4, // in the last update
+		OBSERVED = 8
+	};
+
+	bool HasState(int key, std::uint8_t state) const { return key >= 0 && key < KEY_COUNT && (m_keys[key] & state) != 0; }
+	void QueueEvent(int key, int action);
+	void ApplyEvent(const KeyEvent& event);
+	void WriteRecord(double deltaTime);
+	void ReadReplayEvents();     // of the current record
+	void ReadReplayRecordHeader(); // of the next record: its delta time and number of events
+	static void OnKey(GLFWwindow* window, int key, int scancode, int action, int mods);
+
+	GLFWwindow* m_window = nullptr;
+	std::uint8_t m_keys[KEY_COUNT] = {}; // KeyState bits by key code
+	std::vector<int> m_observedKeys;
+
+	// filled by the callback and emptied by Update, both on the thread that handles the window events
+	KeyEvent m_events[EVENT_CAPACITY];
+	unsigned m_firstEvent = 0;
+	unsigned m_eventCount = 0;
+	bool m_eventsLost = false;
+	std::vector<KeyEvent> m_appliedEvents; // in the last update
+
+	std::ofstream m_recording;
+	double m_recordingStart = 0.0;
+	double m_recordedStep = 0.0;  // the delta time is only written when it changes
+	std::ifstream m_replay;
+	double m_replayStep = -1.0;
+	unsigned m_replayEventCount = 0;
+
+	static std::vector<InputSystem*> s_instances; // receive the events of their window
+	static void (*s_previousCallback)(GLFWwindow*, int, int, int, int);
+};
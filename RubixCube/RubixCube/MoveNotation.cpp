@@ -0,0 +1,182 @@
+#include "MoveNotation.h"
+#include <cstring>
+
+namespace
+{
+	const char LAYER_LETTERS[MOVE_COUNT / 3 + 1] = "URFDLBMESxyz"; // in Move order
+	const int CODE_BITS = 5;
+	const std::size_t HEADER_SIZE = 4;
+
+	bool IsSpace(char c)
+	{
+		return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == ',';
+	}
+
+	int FindLayer(char letter)
+	{
+		if (letter == 'X' || letter == 'Y' || letter == 'Z') // some programs write the rotations in upper case
+			letter = static_cast<char>(letter - 'X' + 'x');
+		for (int layer = 0; layer < MOVE_COUNT / 3; ++layer)
+			if (LAYER_LETTERS[layer] == letter)
+				return layer;
+		return -1;
+	}
+
+	int GetCodeBits(Move move)
+	{
+		return move < MoveNotation::ESCAPE_CODE ? CODE_BITS : 2 * CODE_BITS;
+	}
+}
+
+bool MoveParser::Next(Move& move)
+{
+	if (m_error)
+		return false;
+	while (m_position < m_text.size() && IsSpace(m_text[m_position]))
+		++m_position;
+	if (m_position == m_text.size())
+		return false;
+
+	int layer = FindLayer(m_text[m_position]);
+	if (layer < 0)
+	{
+		m_error = true;
+		return false;
+	}
+
+	std::size_t end = m_position + 1;
+	int power = 0; // quarter turn, double turn or inverse as the offset inside the layer
+	if (end < m_text.size() && m_text[end] == '2')
+	{
+		power = 1;
+		++end;
+		if (end < m_text.size() && m_text[end] == '\'') // R2' is the same as R2
+			++end;
+	}
+	else if (end < m_text.size() && m_text[end] == '\'')
+	{
+		power = 2;
+		++end;
+	}
+
+	move = static_cast<Move>(3 * layer + power);
+	m_position = end;
+	return true;
+}
+
+bool MoveNotation::Parse(std::string_view text, Move* moves, std::size_t capacity, std::size_t& count,
+	std::size_t* errorPosition)
+{
+	MoveParser parser(text);
+	count = 0;
+	Move move;
+	while (parser.Next(move))
+	{
+		if (count == capacity)
+		{
+			if (errorPosition != nullptr)
+				*errorPosition = parser.GetPosition();
+			return false;
+		}
+		moves[count++] = move;
+	}
+	if (parser.HasError() && errorPosition != nullptr)
+		*errorPosition = parser.GetPosition();
+	return !parser.HasError();
+}
+
+std::size_t MoveNotation::Format(const Move* moves, std::size_t count, char* buffer, std::size_t capacity)
+{
+	std::size_t length = 0;
+	for (std::size_t i = 0; i < count; ++i)
+		length += (i > 0 ? 1 : 0) + std::strlen(CubeState::GetMoveName(moves[i]));
+	if (length + 1 > capacity)
+		return length;
+
+	char* out = buffer;
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		if (i > 0)
+			*out++ = ' ';
+		for (const char* name = CubeState::GetMoveName(moves[i]); *name != '\0'; ++name)
+			*out++ = *name;
+	}
+	*out = '\0';
+	return length;
+}
+
+std::size_t MoveNotation::GetPackedSize(const Move* moves, std::size_t count)
+{
+	std::size_t bits = 0;
+	for (std::size_t i = 0; i < count; ++i)
+		bits += GetCodeBits(moves[i]);
+	return HEADER_SIZE + (bits + 7) / 8;
+}
+
+std::size_t MoveNotation::Pack(const Move* moves, std::size_t count, std::uint8_t* buffer, std::size_t capacity)
+{
+	std::size_t size = GetPackedSize(moves, count);
+	if (size > capacity || count > UINT32_MAX)
+		return 0;
+
+	for (std::size_t i = 0; i < HEADER_SIZE; ++i)
+		buffer[i] = static_cast<std::uint8_t>(count >> (8 * i));
+	std::memset(buffer + HEADER_SIZE, 0, size - HEADER_SIZE);
+
+	std::size_t bit = 0;
+	auto write = [&](int code)
+		{
+			for (int i = 0; i < CODE_BITS; ++i, ++bit)
+				buffer[HEADER_SIZE + bit / 8] |= static_cast<std::uint8_t>(((code >> i) & 1) << (bit % 8));
+		};
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		if (moves[i] < ESCAPE_CODE)
+			write(moves[i]);
+		else
+		{
+			write(ESCAPE_CODE);
+			write(moves[i] - ESCAPE_CODE);
+		}
+	}
+	return size;
+}
+
+bool MoveNotation::Unpack(const std::uint8_t* data, std::size_t size, Move* moves, std::size_t capacity, std::size_t& count)
+{
+	count = 0;
+	if (size < HEADER_SIZE)
+		return false;
+	std::size_t total = 0;
+	for (std::size_t i = 0; i < HEADER_SIZE; ++i)
+		total |= static_cast<std::size_t>(data[i]) << (8 * i);
+	if (total > capacity)
+		return false;
+
+	std::size_t bit = 0;
+	std::size_t bitCount = (size - HEADER_SIZE) * 8;
+	auto read = [&](int& code)
+		{
+			if (bit + CODE_BITS > bitCount)
+				return false;
+			code = 0;
+			for (int i = 0; i < CODE_BITS; ++i, ++bit)
+				code |= ((data[HEADER_SIZE + bit / 8] >> (bit % 8)) & 1) << i;
+			return true;
+		};
+	for (std::size_t i = 0; i < total; ++i)
+	{
+		int code;
+		if (!read(code))
+			return false;
+		if (code == ESCAPE_CODE)
+		{
+			int extra;
+			if (!read(extra) || code + extra >= MOVE_COUNT)
+				return false;
+			code += extra;
+		}
+		moves[count++] = static_cast<Move>(code);
+	}
+	return true;
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include "CubeState.h"
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// Reads moves in Singmaster notation ("R U R' U2 M E' x y2") one at a time from a view on the text, without
+// allocating. Moves may be separated by white space or written together ("RUR'U'"); "2'" counts as a double turn.
+class MoveParser
+{
+public:
+	explicit MoveParser(std::string_view text) : m_text(text) {}
+
+	// false at the end of the text or at the first token that is not a move, see HasError
+	bool Next(Move& move);
+
+	bool HasError() const { return m_error; }
+	std::size_t GetPosition() const { return m_position; } // offset of the offending token after an error
+
+private:
+	std::string_view m_text;
+	std::size_t m_position = 0;
+	bool m_error = false;
+};
+
+// Conversions of whole move sequences between arrays, text and a packed binary form, all into caller provided memory.
+// The packed form is a little endian uint32 move count followed by 5 bits per move, least significant bit first.
+// Codes 0..30 are the moves themselves, 31 is followed by another 5 bits holding move - 31.
+class MoveNotation
+{
+public:
+	static const int ESCAPE_CODE = 31;
+
+	// Parses the whole text into moves. Returns false if the text contains something else or more than capacity
+	// moves; count is the number of moves read until then and errorPosition (if given) where reading stopped.
+	static bool Parse(std::string_view text, Move* moves, std::size_t capacity, std::size_t& count,
+		std::size_t* errorPosition = nullptr);
+
+	// Writes the moves separated by spaces and terminated by '\0'. Returns the length without the terminator,
+	// or the length that would be needed if capacity is too small (nothing useful is written then).
+	static std::size_t Format(const Move* moves, std::size_t count, char* buffer, std::size_t capacity);
+
+	static std::size_t GetPackedSize(const Move* moves, std::size_t count); // in bytes, header included
+	// returns the number of bytes written, 0 if capacity is smaller than GetPackedSize
+	static std::size_t Pack(const Move* moves, std::size_t count, std::uint8_t* buffer, std::size_t capacity);
+	// false if the data is truncated, holds an unknown code or more than capacity moves
+	static bool Unpack(const std::uint8_t* data, std::size_t size, Move* moves, std::size_t capacity, std::size_t& count);
+};
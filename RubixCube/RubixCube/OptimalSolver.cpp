@@ -0,0 +1,427 @@
+#include "OptimalSolver.h"
+#include "CubeCoordinates.h"
+#include "CubeSymmetry.h"
+#include "PruningTable.h"
+#include "PruningTableGenerator.h"
+#include "SymmetryClasses.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+
+namespace
+{
+	const int FACE_TURN_COUNT = 18; // U..B' come first in Move
+	const int EDGE_SET_COUNT = 2;   // the edges 0..5 and 6..11 have a pattern database each
+	const int SPLIT_DEPTH = 3;      // the nodes at this depth become the tasks of the thread pool
+	const std::uint32_t TABLE_VERSION = 1; // increase whenever a coordinate or table layout changes
+}
+
+struct OptimalTables
+{
+	const std::uint16_t* cornerPermMove; // [coordinate * FACE_TURN_COUNT + move]
+	const std::uint16_t* twistMove;
+	const std::uint32_t* edgePositionMove[EDGE_SET_COUNT];
+	// [(combination * EDGE6_FLIP_COUNT + flip) * FACE_TURN_COUNT + move], the result has the same layout
+	const std::uint16_t* edgeFlipMove[EDGE_SET_COUNT];
+
+	PruningTable edgePruning[EDGE_SET_COUNT]; // [position * EDGE6_FLIP_COUNT + flip]
+
+	std::vector<std::shared_ptr<TableFile>> files; // keeps the mapped tables alive
+};
+
+// Corner pattern database, either over the raw corner permutation or over its symmetry classes. A cube is looked up
+// through the representative of its class, conjugating the twist along with it.
+struct OptimalCornerPruning
+{
+	std::unique_ptr<SymmetryClasses> classes;    // nullptr without symmetry reduction
+	std::vector<std::uint16_t> twistConjugation; // [symmetry * TWIST_COUNT + twist] for the U-D symmetries
+	PruningTable table;                          // [(class or cornerPerm) * TWIST_COUNT + twist]
+	std::shared_ptr<TableFile> file;
+
+	std::size_t GetIndex(int cornerPerm, int twist) const
+	{
+		if (!classes)
+			return static_cast<std::size_t>(cornerPerm) * CubeCoordinates::TWIST_COUNT + twist;
+		int symmetry = classes->GetSymmetry(cornerPerm);
+		int conjugatedTwist;
+		if (symmetry < CubeSymmetry::UD_SYMMETRY_COUNT) // they keep U/D stickers on U/D, the twist does not depend on the permutation
+			conjugatedTwist = twistConjugation[symmetry * CubeCoordinates::TWIST_COUNT + twist];
+		else
+		{
+			CubeState cube;
+			CubeCoordinates::SetCornerPerm(cube, cornerPerm);
+			CubeCoordinates::SetTwist(cube, twist);
+			conjugatedTwist = CubeCoordinates::GetTwist(CubeSymmetry::Conjugate(cube, symmetry));
+		}
+		return static_cast<std::size_t>(classes->GetClass(cornerPerm)) * CubeCoordinates::TWIST_COUNT + conjugatedTwist;
+	}
+};
+
+namespace
+{
+	struct Node
+	{
+		int cornerPerm;
+		int twist;
+		int edgePosition[EDGE_SET_COUNT];
+		int edgeFlip[EDGE_SET_COUNT];
+	};
+
+	template <int FIRST_PIECE>
+	int GetEdgePosition(const CubeState& cube) { return CubeCoordinates::GetEdge6Position(cube, FIRST_PIECE); }
+	template <int FIRST_PIECE>
+	void SetEdgePosition(CubeState& cube, int position) { CubeCoordinates::SetEdge6Position(cube, FIRST_PIECE, position); }
+
+	// the flip only moves along with the combination of the occupied slots, not with the order of the pieces in them
+	template <int FIRST_PIECE>
+	int GetEdgeCombinationFlip(const CubeState& cube)
+	{
+		return CubeCoordinates::GetEdge6Position(cube, FIRST_PIECE) / 720 * CubeCoordinates::EDGE6_FLIP_COUNT
+			+ CubeCoordinates::GetEdge6Flip(cube, FIRST_PIECE);
+	}
+	template <int FIRST_PIECE>
+	void SetEdgeCombinationFlip(CubeState& cube, int combinationFlip)
+	{
+		CubeCoordinates::SetEdge6Position(cube, FIRST_PIECE, combinationFlip / CubeCoordinates::EDGE6_FLIP_COUNT * 720);
+		CubeCoordinates::SetEdge6Flip(cube, FIRST_PIECE, combinationFlip % CubeCoordinates::EDGE6_FLIP_COUNT);
+	}
+
+	const SolverTables::GetCoordinate GET_EDGE_POSITION[EDGE_SET_COUNT] = { GetEdgePosition<0>, GetEdgePosition<6> };
+	const SolverTables::SetCoordinate SET_EDGE_POSITION[EDGE_SET_COUNT] = { SetEdgePosition<0>, SetEdgePosition<6> };
+	const SolverTables::GetCoordinate GET_EDGE_COMBINATION_FLIP[EDGE_SET_COUNT] = { GetEdgeCombinationFlip<0>, GetEdgeCombinationFlip<6> };
+	const SolverTables::SetCoordinate SET_EDGE_COMBINATION_FLIP[EDGE_SET_COUNT] = { SetEdgeCombinationFlip<0>, SetEdgeCombinationFlip<6> };
+
+	int MoveEdgeFlip(const OptimalTables& tables, int set, int position, int flip, int move)
+	{
+		int combinationFlip = position / 720 * CubeCoordinates::EDGE6_FLIP_COUNT + flip;
+		return tables.edgeFlipMove[set][combinationFlip * FACE_TURN_COUNT + move] % CubeCoordinates::EDGE6_FLIP_COUNT;
+	}
+
+	template <typename T>
+	const T* LoadMoveTable(OptimalTables& tables, const std::string& path,
+		int count, SolverTables::GetCoordinate get, SolverTables::SetCoordinate set, const Move* moves)
+	{
+		auto file = SolverTables::LoadMoveTable<T>(path, TABLE_VERSION, count, get, set, moves, FACE_TURN_COUNT);
+		tables.files.push_back(file);
+		return reinterpret_cast<const T*>(file->GetData());
+	}
+
+	PruningTable LoadPruningTable(OptimalTables& tables, const std::string& path, std::size_t entries,
+		const std::function<void(PruningTable)>& generate)
+	{
+		auto file = SolverTables::LoadPruningTable(path, TABLE_VERSION, entries, generate);
+		tables.files.push_back(file);
+		return PruningTable(file->GetData(), entries);
+	}
+
+	OptimalTables LoadTables(const std::string& directory)
+	{
+		Move faceTurns[FACE_TURN_COUNT];
+		for (int move = 0; move < FACE_TURN_COUNT; ++move)
+			faceTurns[move] = static_cast<Move>(move);
+
+		OptimalTables tables;
+		tables.cornerPermMove = LoadMoveTable<std::uint16_t>(tables, directory + "/OptimalCornerPermMove.tbl",
+			CubeCoordinates::CORNER_PERM_COUNT, CubeCoordinates::GetCornerPerm, CubeCoordinates::SetCornerPerm, faceTurns);
+		tables.twistMove = LoadMoveTable<std::uint16_t>(tables, directory + "/OptimalTwistMove.tbl",
+			CubeCoordinates::TWIST_COUNT, CubeCoordinates::GetTwist, CubeCoordinates::SetTwist, faceTurns);
+
+		for (int set = 0; set < EDGE_SET_COUNT; ++set)
+		{
+			std::string name = directory + "/OptimalEdges" + std::to_string(set);
+			tables.edgePositionMove[set] = LoadMoveTable<std::uint32_t>(tables, name + "PositionMove.tbl",
+				CubeCoordinates::EDGE6_POSITION_COUNT, GET_EDGE_POSITION[set], SET_EDGE_POSITION[set], faceTurns);
+			tables.edgeFlipMove[set] = LoadMoveTable<std::uint16_t>(tables, name + "FlipMove.tbl",
+				CubeCoordinates::EDGE6_COMBINATION_COUNT * CubeCoordinates::EDGE6_FLIP_COUNT,
+				GET_EDGE_COMBINATION_FLIP[set], SET_EDGE_COMBINATION_FLIP[set], faceTurns);
+			tables.edgePruning[set] = LoadPruningTable(tables, name + "Pruning.tbl",
+				static_cast<std::size_t>(CubeCoordinates::EDGE6_POSITION_COUNT) * CubeCoordinates::EDGE6_FLIP_COUNT, [&](PruningTable table)
+				{
+					auto next = [&](std::size_t index, int move)
+						{
+							int position = static_cast<int>(index / CubeCoordinates::EDGE6_FLIP_COUNT);
+							int flip = static_cast<int>(index % CubeCoordinates::EDGE6_FLIP_COUNT);
+							return static_cast<std::size_t>(tables.edgePositionMove[set][position * FACE_TURN_COUNT + move])
+								* CubeCoordinates::EDGE6_FLIP_COUNT + MoveEdgeFlip(tables, set, position, flip, move);
+						};
+					PruningTableGenerator::Generate(table, next, FACE_TURN_COUNT, 0, SolverTables::PrintProgress);
+				});
+		}
+		return tables;
+	}
+
+	const OptimalTables& GetTables(const std::string& directory)
+	{
+		// one set per directory, loaded by the first solver that uses it
+		static std::mutex mutex;
+		static std::map<std::string, std::unique_ptr<OptimalTables>> tables;
+		std::lock_guard<std::mutex> lock(mutex);
+		std::unique_ptr<OptimalTables>& loaded = tables[directory];
+		if (!loaded)
+			loaded = std::make_unique<OptimalTables>(LoadTables(directory));
+		return *loaded;
+	}
+
+	std::unique_ptr<OptimalCornerPruning> LoadCornerPruning(const OptimalTables& tables, const std::string& directory, int symmetryCount)
+	{
+		auto corners = std::make_unique<OptimalCornerPruning>();
+		std::size_t permCount = CubeCoordinates::CORNER_PERM_COUNT;
+		std::string path = directory + "/OptimalCornerPruning.tbl";
+		if (symmetryCount > 1)
+		{
+			corners->classes = std::make_unique<SymmetryClasses>(CubeCoordinates::CORNER_PERM_COUNT,
+				CubeCoordinates::GetCornerPerm, CubeCoordinates::SetCornerPerm, symmetryCount);
+			corners->twistConjugation.resize(CubeSymmetry::UD_SYMMETRY_COUNT * CubeCoordinates::TWIST_COUNT);
+			for (int symmetry = 0; symmetry < CubeSymmetry::UD_SYMMETRY_COUNT; ++symmetry)
+			{
+				for (int twist = 0; twist < CubeCoordinates::TWIST_COUNT; ++twist)
+				{
+					CubeState cube;
+					CubeCoordinates::SetTwist(cube, twist);
+					corners->twistConjugation[symmetry * CubeCoordinates::TWIST_COUNT + twist] =
+						static_cast<std::uint16_t>(CubeCoordinates::GetTwist(CubeSymmetry::Conjugate(cube, symmetry)));
+				}
+			}
+			permCount = corners->classes->GetClassCount();
+			path = directory + "/OptimalCornerPruning" + std::to_string(symmetryCount) + ".tbl";
+		}
+
+		std::size_t entries = permCount * CubeCoordinates::TWIST_COUNT;
+		OptimalCornerPruning* pruning = corners.get();
+		corners->file = SolverTables::LoadPruningTable(path, TABLE_VERSION, entries, [&](PruningTable table)
+			{
+				auto next = [&](std::size_t index, int move)
+					{
+						int perm = static_cast<int>(index / CubeCoordinates::TWIST_COUNT);
+						int twist = static_cast<int>(index % CubeCoordinates::TWIST_COUNT);
+						if (pruning->classes)
+							perm = pruning->classes->GetRepresentative(perm);
+						return pruning->GetIndex(tables.cornerPermMove[perm * FACE_TURN_COUNT + move],
+							tables.twistMove[twist * FACE_TURN_COUNT + move]);
+					};
+				PruningTableGenerator::Generate(table, next, FACE_TURN_COUNT, 0, SolverTables::PrintProgress);
+			});
+		corners->table = PruningTable(corners->file->GetData(), entries);
+		return corners;
+	}
+
+	const OptimalCornerPruning& GetCornerPruning(const std::string& directory, int symmetryCount)
+	{
+		// one table per directory and symmetry option, loaded by the first solver that uses it
+		static std::mutex mutex;
+		static std::map<std::pair<std::string, int>, std::unique_ptr<OptimalCornerPruning>> tables;
+		std::lock_guard<std::mutex> lock(mutex);
+		std::unique_ptr<OptimalCornerPruning>& corners = tables[{ directory, symmetryCount }];
+		if (!corners)
+			corners = LoadCornerPruning(GetTables(directory), directory, symmetryCount);
+		return *corners;
+	}
+
+	Node GetNode(const CubeState& cube)
+	{
+		Node node;
+		node.cornerPerm = CubeCoordinates::GetCornerPerm(cube);
+		node.twist = CubeCoordinates::GetTwist(cube);
+		for (int set = 0; set < EDGE_SET_COUNT; ++set)
+		{
+			node.edgePosition[set] = GET_EDGE_POSITION[set](cube);
+			node.edgeFlip[set] = CubeCoordinates::GetEdge6Flip(cube, set * 6);
+		}
+		return node;
+	}
+
+	class Search
+	{
+	public:
+		// a search for task taskIndex gives up as soon as a task with a lower index found a solution
+		Search(const OptimalTables& tables, const OptimalCornerPruning& corners, const std::atomic<int>* bestTask = nullptr, int taskIndex = 0)
+			: m_tables(tables), m_corners(corners), m_bestTask(bestTask), m_taskIndex(taskIndex) {}
+
+		Node ApplyMove(const Node& node, int move) const
+		{
+			Node next;
+			next.cornerPerm = m_tables.cornerPermMove[node.cornerPerm * FACE_TURN_COUNT + move];
+			next.twist = m_tables.twistMove[node.twist * FACE_TURN_COUNT + move];
+			for (int set = 0; set < EDGE_SET_COUNT; ++set)
+			{
+				next.edgePosition[set] = m_tables.edgePositionMove[set][node.edgePosition[set] * FACE_TURN_COUNT + move];
+				next.edgeFlip[set] = MoveEdgeFlip(m_tables, set, node.edgePosition[set], node.edgeFlip[set], move);
+			}
+			return next;
+		}
+
+		int Distance(const Node& node) const
+		{
+			int distance = m_corners.table.Get(m_corners.GetIndex(node.cornerPerm, node.twist));
+			for (int set = 0; set < EDGE_SET_COUNT; ++set)
+			{
+				std::size_t index = static_cast<std::size_t>(node.edgePosition[set]) * CubeCoordinates::EDGE6_FLIP_COUNT + node.edgeFlip[set];
+				distance = std::max(distance, m_tables.edgePruning[set].Get(index));
+			}
+			return distance;
+		}
+
+		// turning the same face twice in a row, or opposite faces in both orders, never shortens a solution
+		bool IsRedundant(int move, int depth) const
+		{
+			if (depth == 0)
+				return false;
+			int face = move / 3;
+			int lastFace = m_path[depth - 1] / 3;
+			return face == lastFace || face == lastFace - 3;
+		}
+
+		// depth first search for exactly togo more moves; the path up to depth has to be set already
+		bool Run(const Node& node, int depth, int togo)
+		{
+			if (m_bestTask != nullptr && m_bestTask->load(std::memory_order_relaxed) < m_taskIndex)
+				return false;
+			if (togo == 0)
+			{
+				m_length = depth;
+				return Distance(node) == 0; // only the solved cube has distance 0 in every table
+			}
+
+			for (int move = 0; move < FACE_TURN_COUNT; ++move)
+			{
+				if (IsRedundant(move, depth))
+					continue;
+				Node next = ApplyMove(node, move);
+				if (Distance(next) > togo - 1)
+					continue;
+				m_path[depth] = static_cast<Move>(move);
+				if (Run(next, depth + 1, togo - 1))
+					return true;
+			}
+			return false;
+		}
+
+		// all nodes SPLIT_DEPTH moves below node that can still reach the goal within bound, in search order
+		void CollectTasks(const Node& node, int depth, int bound, std::vector<std::pair<Node, int>>& nodes, std::vector<Move>& paths)
+		{
+			if (depth == SPLIT_DEPTH)
+			{
+				nodes.emplace_back(node, static_cast<int>(paths.size()));
+				paths.insert(paths.end(), m_path, m_path + SPLIT_DEPTH);
+				return;
+			}
+			for (int move = 0; move < FACE_TURN_COUNT; ++move)
+			{
+				if (IsRedundant(move, depth))
+					continue;
+				Node next = ApplyMove(node, move);
+				if (Distance(next) > bound - depth - 1)
+					continue;
+				m_path[depth] = static_cast<Move>(move);
+				CollectTasks(next, depth + 1, bound, nodes, paths);
+			}
+		}
+
+		Move m_path[OptimalSolver::MAX_LENGTH];
+		int m_length = 0;
+
+	private:
+		const OptimalTables& m_tables;
+		const OptimalCornerPruning& m_corners;
+		const std::atomic<int>* m_bestTask;
+		int m_taskIndex;
+	};
+}
+
+OptimalSolver::OptimalSolver(const std::string& tableDirectory, int threadCount, int cornerSymmetryCount)
+	: m_tables(&GetTables(tableDirectory))
+	, m_corners(&GetCornerPruning(tableDirectory,
+		cornerSymmetryCount == CubeSymmetry::UD_SYMMETRY_COUNT || cornerSymmetryCount == CubeSymmetry::SYMMETRY_COUNT ? cornerSymmetryCount : 1))
+{
+	if (threadCount != 1)
+		m_pool = std::make_unique<ThreadPool>(threadCount);
+}
+
+OptimalSolver::~OptimalSolver() = default;
+
+bool OptimalSolver::Solve(const CubeState& cube, std::vector<Move>& solution, int maxLength, SearchStatistics* statistics) const
+{
+	solution.clear();
+	Move fix[2];
+	int fixLength = cube.FindCenterFix(fix);
+	if (fixLength < 0)
+		return false;
+	CubeState centered = cube;
+	for (int i = 0; i < fixLength; ++i)
+		centered.ApplyMove(fix[i]);
+	if (!CubeCoordinates::IsSolvable(centered))
+		return false;
+
+	const OptimalTables& tables = *m_tables;
+	const OptimalCornerPruning& corners = *m_corners;
+	Search root(tables, corners);
+	Node start = GetNode(centered);
+	maxLength = std::min(maxLength, MAX_LENGTH);
+	for (int bound = root.Distance(start); bound <= maxLength; ++bound)
+	{
+		if (!m_pool || bound <= SPLIT_DEPTH)
+		{
+			if (root.Run(start, 0, bound))
+			{
+				solution.assign(fix, fix + fixLength);
+				solution.insert(solution.end(), root.m_path, root.m_path + root.m_length);
+				return true;
+			}
+			continue;
+		}
+
+		// Every task searches below one node at SPLIT_DEPTH. The single threaded search would return the solution of
+		// the first task in search order that has one, so only tasks after the best one found so far are cancelled.
+		std::vector<std::pair<Node, int>> nodes;
+		std::vector<Move> prefixes;
+		root.CollectTasks(start, 0, bound, nodes, prefixes);
+		std::atomic<int> bestTask(INT_MAX);
+		std::atomic<int> cancelledCount(0);
+		std::vector<Move> solutions(nodes.size() * bound); // every task writes only its own solution
+		for (int task = 0; task < static_cast<int>(nodes.size()); ++task) // submitted in search order, so they start in it
+		{
+			m_pool->Submit([&, task]()
+				{
+					if (bestTask.load(std::memory_order_relaxed) < task)
+					{
+						++cancelledCount;
+						return;
+					}
+					Search search(tables, corners, &bestTask, task);
+					auto prefix = prefixes.begin() + nodes[task].second;
+					std::copy(prefix, prefix + SPLIT_DEPTH, search.m_path);
+					if (!search.Run(nodes[task].first, SPLIT_DEPTH, bound - SPLIT_DEPTH))
+					{
+						if (bestTask.load() < task)
+							++cancelledCount;
+						return;
+					}
+					std::copy(search.m_path, search.m_path + bound, solutions.begin() + task * bound);
+					int current = bestTask.load();
+					while (task < current && !bestTask.compare_exchange_weak(current, task)) {}
+				});
+		}
+		m_pool->Wait();
+
+		if (statistics != nullptr)
+		{
+			statistics->taskCount = static_cast<int>(nodes.size());
+			statistics->bestTask = bestTask.load() != INT_MAX ? bestTask.load() : -1;
+			statistics->cancelledCount = cancelledCount.load();
+		}
+		if (bestTask.load() != INT_MAX)
+		{
+			solution.assign(fix, fix + fixLength);
+			auto best = solutions.begin() + bestTask.load() * bound;
+			solution.insert(solution.end(), best, best + bound);
+			return true;
+		}
+	}
+	return false;
+}
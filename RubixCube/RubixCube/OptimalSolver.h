@@ -0,0 +1,47 @@
+#pragma once
+#include "CubeState.h"
+#include "CubeSymmetry.h"
+#include "SolverTables.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+struct OptimalTables;
+struct OptimalCornerPruning;
+class ThreadPool;
+
+// IDA* search for a shortest solution in face turns, guided by a corner pattern database and two databases for
+// six edges each. Below the first moves the search tree is split into tasks for a thread pool; the answer is the
+// same as the one of a single threaded run. The tables are shared by all solvers with the same tableDirectory and are
+// loaded by the first of them (about 140 MB in tableDirectory, building them takes a while). The corner database can be indexed by symmetry
+// classes of the corner permutation: 16 symmetries shrink it from 44 MB to 3 MB, 48 to 1 MB at the price of
+// slower lookups for the symmetries that move the U-D axis.
+class OptimalSolver
+{
+public:
+	static const int MAX_LENGTH = 20; // every cube can be solved in 20 face turns
+
+	// of the last bound of a Solve, if it was split into tasks for the thread pool
+	struct SearchStatistics
+	{
+		int taskCount = 0;
+		int bestTask = -1;      // the task whose solution was returned
+		int cancelledCount = 0; // skipped or stopped early because a task before them had found a solution
+	};
+
+	// threadCount 0 uses one thread per core, 1 searches on the calling thread only;
+	// cornerSymmetryCount is 1 (no reduction), 16 or 48
+	explicit OptimalSolver(const std::string& tableDirectory = SolverTables::DEFAULT_DIRECTORY, int threadCount = 0,
+		int cornerSymmetryCount = CubeSymmetry::UD_SYMMETRY_COUNT);
+	~OptimalSolver();
+
+	// Finds a shortest solution of at most maxLength face turns. Slice turns that bring displaced centers back
+	// are put in front like in TwoPhaseSolver. Returns false if the cube is not solvable within maxLength.
+	bool Solve(const CubeState& cube, std::vector<Move>& solution, int maxLength = MAX_LENGTH,
+		SearchStatistics* statistics = nullptr) const;
+
+private:
+	const OptimalTables* m_tables;         // both shared with all solvers of the same table directory
+	const OptimalCornerPruning* m_corners; // and corner symmetry count
+	std::unique_ptr<ThreadPool> m_pool;
+};
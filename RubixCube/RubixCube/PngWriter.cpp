@@ -0,0 +1,192 @@
+#include "PngWriter.h"
+#include <fstream>
+#include <iostream>
+
+namespace
+{
+	const int BYTES_PER_PIXEL = 4;
+	const int MIN_MATCH = 3;
+	const int MAX_MATCH = 258;
+
+	// deflate length codes 257 to 285: shortest length and number of extra bits
+	const int LENGTH_BASE[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+	const int LENGTH_EXTRA[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+
+	// collects bits least significant first, as deflate stores them
+	class BitWriter
+	{
+	public:
+		explicit BitWriter(std::vector<std::uint8_t>& output) : m_output(output) {}
+
+		void Write(std::uint32_t value, int bitCount)
+		{
+			m_buffer |= value << m_count;
+			m_count += bitCount;
+			while (m_count >= 8)
+			{
+				m_output.push_back(static_cast<std::uint8_t>(m_buffer));
+				m_buffer >>= 8;
+				m_count -= 8;
+			}
+		}
+
+		void WriteHuffman(std::uint32_t code, int bitCount) // Huffman codes are stored most significant bit first
+		{
+			std::uint32_t reversed = 0;
+			for (int i = 0; i < bitCount; ++i)
+				reversed |= ((code >> i) & 1u) << (bitCount - 1 - i);
+			Write(reversed, bitCount);
+		}
+
+		void Flush()
+		{
+			if (m_count > 0)
+				m_output.push_back(static_cast<std::uint8_t>(m_buffer));
+			m_buffer = 0;
+			m_count = 0;
+		}
+
+	private:
+		std::vector<std::uint8_t>& m_output;
+		std::uint32_t m_buffer = 0;
+		int m_count = 0;
+	};
+
+	void WriteLiteralOrLength(BitWriter& bits, int symbol) // with the fixed Huffman codes of deflate
+	{
+		if (symbol < 144)
+			bits.WriteHuffman(0x30 + symbol, 8);
+		else if (symbol < 256)
+			bits.WriteHuffman(0x190 + symbol - 144, 9);
+		else if (symbol < 280)
+			bits.WriteHuffman(symbol - 256, 7);
+		else
+			bits.WriteHuffman(0xC0 + symbol - 280, 8);
+	}
+
+	void AppendBigEndian(std::vector<std::uint8_t>& output, std::uint32_t value)
+	{
+		for (int shift = 24; shift >= 0; shift -= 8)
+			output.push_back(static_cast<std::uint8_t>(value >> shift));
+	}
+}
+
+void PngWriter::Encode(int width, int height, const std::uint8_t* pixels, std::ptrdiff_t rowStride, std::vector<std::uint8_t>& png)
+{
+	// every row starts with its filter type, 0 leaves the pixels as they are
+	std::size_t rowSize = static_cast<std::size_t>(width) * BYTES_PER_PIXEL;
+	std::vector<std::uint8_t> rows;
+	rows.reserve((rowSize + 1) * height);
+	for (int y = 0; y < height; ++y)
+	{
+		const std::uint8_t* row = pixels + y * rowStride;
+		rows.push_back(0);
+		rows.insert(rows.end(), row, row + rowSize);
+	}
+	std::vector<std::uint8_t> compressed;
+	Deflate(rows, compressed);
+
+	static const std::uint8_t SIGNATURE[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+	png.assign(SIGNATURE, SIGNATURE + 8);
+
+	std::vector<std::uint8_t> header;
+	AppendBigEndian(header, static_cast<std::uint32_t>(width));
+	AppendBigEndian(header, static_cast<std::uint32_t>(height));
+	const std::uint8_t format[5] = { 8, 6, 0, 0, 0 }; // 8 bit RGBA, deflate, adaptive filtering, no interlacing
+	header.insert(header.end(), format, format + 5);
+	AppendChunk(png, "IHDR", header.data(), header.size());
+	AppendChunk(png, "IDAT", compressed.data(), compressed.size());
+	AppendChunk(png, "IEND", nullptr, 0);
+}
+
+bool PngWriter::Write(const char* fileName, int width, int height, const std::uint8_t* pixels, std::ptrdiff_t rowStride)
+{
+	std::vector<std::uint8_t> png;
+	Encode(width, height, pixels, rowStride, png);
+
+	std::ofstream file(fileName, std::ios::binary);
+	if (!file.write(reinterpret_cast<const char*>(png.data()), png.size()))
+	{
+		std::cerr << "Could not write " << fileName << std::endl;
+		return false;
+	}
+	return true;
+}
+
+void PngWriter::Deflate(const std::vector<std::uint8_t>& data, std::vector<std::uint8_t>& zlib)
+{
+	zlib.clear();
+	zlib.push_back(0x78); // deflate with a 32K window
+	zlib.push_back(0x01); // no preset dictionary, fastest compression; makes the header a multiple of 31
+
+	BitWriter bits(zlib);
+	bits.Write(1, 1); // the only and so the last block
+	bits.Write(1, 2); // fixed Huffman codes
+
+	// the only matches searched for repeat the previous pixel, i.e. start 4 bytes back and may overlap themselves
+	std::size_t size = data.size();
+	std::size_t i = 0;
+	while (i < size)
+	{
+		std::size_t length = 0;
+		if (i >= BYTES_PER_PIXEL)
+			while (length < MAX_MATCH && i + length < size && data[i + length] == data[i + length - BYTES_PER_PIXEL])
+				++length;
+
+		if (length < MIN_MATCH)
+		{
+			WriteLiteralOrLength(bits, data[i]);
+			++i;
+			continue;
+		}
+
+		int code = 28;
+		while (LENGTH_BASE[code] > static_cast<int>(length))
+			--code;
+		WriteLiteralOrLength(bits, 257 + code);
+		bits.Write(static_cast<std::uint32_t>(length - LENGTH_BASE[code]), LENGTH_EXTRA[code]);
+		bits.WriteHuffman(BYTES_PER_PIXEL - 1, 5); // distance code 3 stands for a distance of 4 without extra bits
+		i += length;
+	}
+	WriteLiteralOrLength(bits, 256); // end of block
+	bits.Flush();
+
+	std::uint32_t a = 1, b = 0; // Adler-32 of the uncompressed data
+	for (std::uint8_t byte : data)
+	{
+		a = (a + byte) % 65521;
+		b = (b + a) % 65521;
+	}
+	AppendBigEndian(zlib, (b << 16) | a);
+}
+
+void PngWriter::AppendChunk(std::vector<std::uint8_t>& png, const char* type, const std::uint8_t* data, std::size_t size)
+{
+	AppendBigEndian(png, static_cast<std::uint32_t>(size));
+	std::size_t start = png.size();
+	png.insert(png.end(), type, type + 4);
+	if (size > 0)
+		png.insert(png.end(), data, data + size);
+	AppendBigEndian(png, GetCrc(png.data() + start, png.size() - start, 0));
+}
+
+std::uint32_t PngWriter::GetCrc(const std::uint8_t* data, std::size_t size, std::uint32_t crc)
+{
+	static std::uint32_t table[256];
+	static bool tableBuilt = [] {
+		for (std::uint32_t n = 0; n < 256; ++n)
+		{
+			std::uint32_t c = n;
+			for (int k = 0; k < 8; ++k)
+				c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+			table[n] = c;
+		}
+		return true;
+	}();
+	(void)tableBuilt;
+
+	crc = ~crc;
+	for (std::size_t i = 0; i < size; ++i)
+		crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+	return ~crc;
+}
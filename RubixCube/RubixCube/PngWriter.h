@@ -0,0 +1,20 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Encodes 8 bit RGBA images as PNG. The image data is compressed with fixed Huffman codes and repeats of the previous
+// pixel only, which is quick and shrinks the large uniform areas of rendered images well; it is not meant to compete
+// with a full deflate implementation on photos.
+class PngWriter
+{
+public:
+	// rowStride is the distance in bytes from the first to the second row of the image, negative for bottom up data
+	static void Encode(int width, int height, const std::uint8_t* pixels, std::ptrdiff_t rowStride, std::vector<std::uint8_t>& png);
+	static bool Write(const char* fileName, int width, int height, const std::uint8_t* pixels, std::ptrdiff_t rowStride);
+
+private:
+	static void Deflate(const std::vector<std::uint8_t>& data, std::vector<std::uint8_t>& zlib);
+	static void AppendChunk(std::vector<std::uint8_t>& png, const char* type, const std::uint8_t* data, std::size_t size);
+	static std::uint32_t GetCrc(const std::uint8_t* data, std::size_t size, std::uint32_t crc);
+};
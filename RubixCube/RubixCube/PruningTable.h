@@ -0,0 +1,59 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// Distances to the goal packed into 4 bits per entry; EMPTY marks entries the search has not reached yet.
+// The table only views its memory, which usually belongs to a TableFile.
+class PruningTable
+{
+public:
+	static const int EMPTY = 0xF;
+
+	PruningTable() : m_data(nullptr), m_size(0) {}
+	PruningTable(const std::uint8_t* data, std::size_t size) : m_data(const_cast<std::uint8_t*>(data)), m_size(size) {}
+
+	static std::size_t GetByteSize(std::size_t size) { return (size + 1) / 2; }
+
+	std::size_t GetSize() const { return m_size; }
+
+	void Clear() { std::memset(m_data, 0xFF, GetByteSize(m_size)); } // only for tables that are being built
+
+	int Get(std::size_t index) const { return (m_data[index >> 1] >> ((index & 1) << 2)) & 0xF; }
+	void Set(std::size_t index, int distance)
+	{
+		int shift = static_cast<int>((index & 1) << 2);
+		m_data[index >> 1] = static_cast<std::uint8_t>((m_data[index >> 1] & ~(0xF << shift)) | (distance << shift));
+	}
+
+	// thread safe variants used while several threads fill the table
+	int GetAtomic(std::size_t index) const
+	{
+		return (GetAtomicByte(index).load(std::memory_order_relaxed) >> ((index & 1) << 2)) & 0xF;
+	}
+	bool SetIfEmptyAtomic(std::size_t index, int distance) // returns false if another thread was faster
+	{
+		std::atomic<std::uint8_t>& byte = GetAtomicByte(index);
+		int shift = static_cast<int>((index & 1) << 2);
+		std::uint8_t expected = byte.load(std::memory_order_relaxed);
+		while (((expected >> shift) & 0xF) == EMPTY)
+		{
+			std::uint8_t desired = static_cast<std::uint8_t>((expected & ~(0xF << shift)) | (distance << shift));
+			if (byte.compare_exchange_weak(expected, desired, std::memory_order_relaxed))
+				return true;
+		}
+		return false;
+	}
+
+private:
+	static_assert(sizeof(std::atomic<std::uint8_t>) == 1, "nibbles are updated through byte sized atomics");
+
+	std::atomic<std::uint8_t>& GetAtomicByte(std::size_t index) const
+	{
+		return reinterpret_cast<std::atomic<std::uint8_t>&>(m_data[index >> 1]);
+	}
+
+	std::uint8_t* m_data;
+	std::size_t m_size;
+};
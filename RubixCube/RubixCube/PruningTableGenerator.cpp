@@ -0,0 +1,44 @@
+#include "PruningTableGenerator.h"
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	const std::size_t CHUNK_SIZE = 1 << 16; // even, so two threads never write into the same byte through their own ranges
+}
+
+int PruningTableGenerator::GetThreadCount(int threadCount)
+{
+	if (threadCount > 0)
+		return threadCount;
+	return std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+}
+
+std::size_t PruningTableGenerator::RunPartitioned(std::size_t size, int threadCount,
+	const std::function<std::size_t(std::size_t, std::size_t)>& work)
+{
+	if (threadCount <= 1 || size <= CHUNK_SIZE)
+		return work(0, size);
+
+	// threads take chunks from a shared counter because the entries of one depth are not spread evenly
+	std::atomic<std::size_t> nextChunk(0);
+	std::atomic<std::size_t> total(0);
+	auto worker = [&]()
+		{
+			std::size_t count = 0;
+			for (std::size_t begin = nextChunk.fetch_add(CHUNK_SIZE); begin < size; begin = nextChunk.fetch_add(CHUNK_SIZE))
+				count += work(begin, std::min(begin + CHUNK_SIZE, size));
+			total += count;
+		};
+
+	std::vector<std::thread> threads;
+	int chunkCount = static_cast<int>((size + CHUNK_SIZE - 1) / CHUNK_SIZE);
+	for (int i = 1; i < std::min(threadCount, chunkCount); ++i)
+		threads.emplace_back(worker);
+	worker();
+	for (std::thread& thread : threads)
+		thread.join();
+	return total;
+}
@@ -0,0 +1,88 @@
+#pragma once
+#include "PruningTable.h"
+#include <cstddef>
+#include <functional>
+
+// Fills pruning tables by a breadth first search from the solved state at index 0. next(index, move) returns the
+// entry reached by one of moveCount moves; the moves have to contain their own inverses. Every depth is split into
+// index ranges that are worked on by several threads. The result does not depend on the thread count,
+// threadCount = 1 is the single threaded reference.
+class PruningTableGenerator
+{
+public:
+	typedef std::function<void(int depth, std::size_t filled, std::size_t size)> ProgressCallback;
+
+	template <typename Next>
+	static void Generate(PruningTable table, const Next& next, int moveCount,
+		int threadCount = 0, const ProgressCallback& progress = nullptr);
+
+	// entries are the product a * countB + b of two coordinates with move tables laid out as [coordinate * moveCount + move]
+	template <typename MoveA, typename MoveB>
+	static void Generate(PruningTable table, const MoveA* moveA, const MoveB* moveB, std::size_t countB, int moveCount,
+		int threadCount = 0, const ProgressCallback& progress = nullptr);
+
+	static int GetThreadCount(int threadCount); // 0 means one thread per core
+
+private:
+	// calls work on disjoint ranges of [0, size) from threadCount threads and returns the sum of its results
+	static std::size_t RunPartitioned(std::size_t size, int threadCount,
+		const std::function<std::size_t(std::size_t, std::size_t)>& work);
+};
+
+template <typename Next>
+void PruningTableGenerator::Generate(PruningTable table, const Next& next, int moveCount,
+	int threadCount, const ProgressCallback& progress)
+{
+	table.Clear();
+	table.Set(0, 0);
+	threadCount = GetThreadCount(threadCount);
+	std::size_t size = table.GetSize();
+	std::size_t filled = 1;
+	for (int depth = 0; filled < size && depth < PruningTable::EMPTY - 1; ++depth)
+	{
+		// once most entries are reached it is cheaper to search from the empty ones towards the current depth
+		bool backward = filled > size / 2;
+		std::size_t added = RunPartitioned(size, threadCount, [&](std::size_t begin, std::size_t end)
+			{
+				std::size_t count = 0;
+				for (std::size_t index = begin; index < end; ++index)
+				{
+					if (table.GetAtomic(index) != (backward ? PruningTable::EMPTY : depth))
+						continue;
+					for (int move = 0; move < moveCount; ++move)
+					{
+						std::size_t neighbour = next(index, move);
+						if (backward)
+						{
+							if (table.GetAtomic(neighbour) == depth)
+							{
+								count += table.SetIfEmptyAtomic(index, depth + 1);
+								break;
+							}
+						}
+						else if (table.SetIfEmptyAtomic(neighbour, depth + 1))
+							++count;
+					}
+				}
+				return count;
+			});
+		filled += added;
+		if (progress)
+			progress(depth + 1, filled, size);
+		if (added == 0)
+			break;
+	}
+}
+
+template <typename MoveA, typename MoveB>
+void PruningTableGenerator::Generate(PruningTable table, const MoveA* moveA, const MoveB* moveB, std::size_t countB,
+	int moveCount, int threadCount, const ProgressCallback& progress)
+{
+	auto next = [=](std::size_t index, int move)
+		{
+			std::size_t a = index / countB;
+			std::size_t b = index % countB;
+			return static_cast<std::size_t>(moveA[a * moveCount + move]) * countB + moveB[b * moveCount + move];
+		};
+	Generate(table, next, moveCount, threadCount, progress);
+}
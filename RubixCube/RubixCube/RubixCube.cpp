@@ -3,6 +3,22 @@
 #include <GLFW/glfw3.h>
 #include "GameInterface.h"
 #include "CubeLogic.h"
+#include "CubeThumbnailRenderer.h"
+#include "MoveNotation.h"
+#include "ShaderUtil.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
 
 // glmw = Generic Library for Mathematics
 // glm  = OpenGL Mathematics
@@ -13,26 +29,137 @@
 GameInterface* g_myInterface; // for testing
 GameInterface g_dummyInterface;
 CubeLogic g_testCompound;
+bool g_redrawRequested = true; // set by the window callbacks: input arrived or the window has to be painted again
+
+// the window state the render thread needs; GLFW only answers such queries on the main thread
+std::atomic<int> g_framebufferWidth(0);
+std::atomic<int> g_framebufferHeight(0);
+std::atomic<bool> g_minimized(false);
+
+// wakes the render thread, all guarded by g_frameMutex
+std::mutex g_frameMutex;
+std::condition_variable g_frameRequest;
+bool g_framePending = false;  // a new state was published
+bool g_animating = true;      // the render thread keeps drawing without waiting for requests
+bool g_rendering = true;      // cleared when the render thread has to stop
+
+const double IDLE_TIMEOUT = 0.5; // seconds the power saving loop sleeps at most without any event
+const double FIXED_TIME_STEP = 1.0 / 120.0; // seconds simulated by every Update, independent of the frame rate
+const double MAX_FRAME_TIME = 0.25;         // longer frames slow the simulation down instead of piling up steps
+
+struct GameOptions
+{
+    bool powerSaving = true;
+    bool vsync = true;
+    double maxFramesPerSecond = 0.0; // no limit
+    bool renderThread = true;        // if the game supports it, see GameInterface::SupportsRenderThread
+    std::string thumbnailInput;      // scrambles to render into images instead of running the game, if not empty
+    std::string thumbnailDirectory;
+    int thumbnailSize = 128;         // pixels, both directions
+    std::string shaderDirectory;     // load the shaders from here and reload them on changes, instead of the embedded ones
+    std::string recordFile;          // writes the input of every update into this log, see InputSystem
+    std::string replayFile;          // plays this input log back as fast as possible and reports the frame times
+    bool headless = false;           // the replay draws into a hidden window
+};
+
+const size_t THUMBNAIL_CHUNK_SIZE = 4096; // scrambles read before their images are rendered
 
 /**
-* \brief Initializes the complete OpenGL stuff and returns a window.
-* \return Opened window to paint into.
+* \brief Any key event may change the picture; the game itself still polls the key states.
+*/
+void OnKey(GLFWwindow* window, int key, int scancode, int action, int mods)
+{
+    g_redrawRequested = true;
+}
+
+/**
+* \brief The window was resized, the picture needs the new aspect ratio.
+*/
+void OnFramebufferSize(GLFWwindow* window, int width, int height)
+{
+    g_framebufferWidth = width;
+    g_framebufferHeight = height;
+    g_redrawRequested = true;
+}
+
+/**
+* \brief Nothing is drawn into a minimized window.
+*/
+void OnWindowIconify(GLFWwindow* window, int iconified)
+{
+    g_minimized = iconified != 0;
+    g_redrawRequested = true;
+}
+
+/**
+* \brief The window was uncovered or restored and its content is lost.
 */
-GLFWwindow* InitializeSystem()
+void OnWindowRefresh(GLFWwindow* window)
 {
-    glfwInit();
+    g_redrawRequested = true;
+}
+
+/**
+* \brief Initializes GLFW and opens a window with an OpenGL 3.3 core context, reporting on std::cerr why if it fails.
+* A hidden window falls back on an OSMesa software context when the driver cannot create one, e.g. on a build machine
+* without a GPU; GLFW loads OSMesa from next to the executable. GLFW itself still needs a display, on Linux e.g. Xvfb.
+* \param debugContext Whether the context reports errors through the debug output.
+* \return The window, nullptr after glfwTerminate if there is none.
+*/
+GLFWwindow* CreateContextWindow(int width, int height, bool visible, bool debugContext)
+{
+    if (!glfwInit())
+    {
+        std::cerr << "Could not initialize GLFW, there may be no display to connect to" << std::endl;
+        return nullptr;
+    }
 
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-    glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, true);
+    glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, debugContext);
+    glfwWindowHint(GLFW_VISIBLE, visible ? GLFW_TRUE : GLFW_FALSE);
+    GLFWwindow* window = glfwCreateWindow(width, height, "Rubix Cube", nullptr, nullptr);
+    if (window == nullptr && !visible)
+    {
+        glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_OSMESA_CONTEXT_API);
+        window = glfwCreateWindow(width, height, "Rubix Cube", nullptr, nullptr);
+    }
+    if (window == nullptr)
+    {
+        std::cerr << "Could not create an OpenGL 3.3 context" << (visible ? "" : ", not even with OSMesa") << std::endl;
+        glfwTerminate();
+    }
+    return window;
+}
 
-    GLFWwindow* window = glfwCreateWindow(1024, 768, "Rubix Cube", nullptr, nullptr);
+/**
+* \brief Initializes the complete OpenGL stuff and returns a window.
+* \param vsync Whether buffer swaps wait for the vertical retrace.
+* \param visible Whether the window is shown; a hidden one still has a default framebuffer to draw into.
+* \return Opened window to paint into, nullptr if there is no OpenGL context, see CreateContextWindow.
+*/
+GLFWwindow* InitializeSystem(bool vsync, bool visible)
+{
+    GLFWwindow* window = CreateContextWindow(1024, 768, visible, true);
+    if (window == nullptr)
+        return nullptr;
     glfwMakeContextCurrent(window);
+    glfwSwapInterval(vsync ? 1 : 0);
 
     glewExperimental = true;
     glewInit();
 
+    glfwSetKeyCallback(window, OnKey);
+    glfwSetFramebufferSizeCallback(window, OnFramebufferSize);
+    glfwSetWindowRefreshCallback(window, OnWindowRefresh);
+    glfwSetWindowIconifyCallback(window, OnWindowIconify);
+
+    int screenWidth, screenHeight;
+    glfwGetFramebufferSize(window, &screenWidth, &screenHeight);
+    g_framebufferWidth = screenWidth;
+    g_framebufferHeight = screenHeight;
+
     g_myInterface->Initialize(window);
 
     return window;
@@ -40,19 +167,38 @@ GLFWwindow* InitializeSystem()
 
 /**
 * \biref Runs the core loop of the game.
+* The game is updated in fixed steps of FIXED_TIME_STEP; every frame shows the state between the last two steps.
 * \param The window to display our stuff in.
+* \param options Power saving: sleeps until input arrives or the window needs painting while nothing animates,
+*        instead of drawing frames as fast as possible. Frame limit: frames per second the loop does not exceed.
 */
-void RunCoreLoop(GLFWwindow* window)
+void RunCoreLoop(GLFWwindow* window, const GameOptions& options)
 {
-    // calculate deltaTime
     double lastTime = glfwGetTime();
-    double timeDifference = 0.0; // zum debuggen auf fest auf z.b. 0.016 (16 ms) setzen
+    double accumulator = FIXED_TIME_STEP; // simulated time still owed; the first frame updates once right away
 
     while (!glfwWindowShouldClose(window))
     {
-        glfwPollEvents();
+        if (options.powerSaving && !g_redrawRequested && !g_myInterface->IsAnimating())
+        {
+            glfwWaitEventsTimeout(IDLE_TIMEOUT);
+            if (!g_redrawRequested)
+                continue; // the timeout or an event that does not change the picture, e.g. a mouse move
+            lastTime = glfwGetTime(); // the time spent sleeping is not simulated, but the input is handled at once
+            accumulator = FIXED_TIME_STEP;
+        }
+        else
+            glfwPollEvents();
+        g_redrawRequested = false;
 
-        g_myInterface->Update(timeDifference);
+        double frameStart = glfwGetTime();
+        accumulator += std::min(frameStart - lastTime, MAX_FRAME_TIME);
+        lastTime = frameStart;
+        while (accumulator >= FIXED_TIME_STEP)
+        {
+            g_myInterface->Update(FIXED_TIME_STEP);
+            accumulator -= FIXED_TIME_STEP;
+        }
 
         int screenWidth, screenHeight;
         glfwGetFramebufferSize(window, &screenWidth, &screenHeight);
@@ -67,15 +213,257 @@ void RunCoreLoop(GLFWwindow* window)
         int minimized = glfwGetWindowAttrib(window, GLFW_ICONIFIED);
         if (!minimized)
         {
-            g_myInterface->Render(aspectRatio);
+            g_myInterface->Render(aspectRatio, accumulator / FIXED_TIME_STEP);
         }
         
         glfwSwapBuffers(window);
-        double currentTime = glfwGetTime();
-        timeDifference = currentTime - lastTime;
-        lastTime = currentTime;
 
+        if (options.maxFramesPerSecond > 0.0)
+        {
+            double remaining = frameStart + 1.0 / options.maxFramesPerSecond - glfwGetTime();
+            if (remaining > 0.0)
+                std::this_thread::sleep_for(std::chrono::duration<double>(remaining));
+        }
+    }
+}
+
+/**
+* \brief Hands a new state over to the render thread.
+* \param animating Whether the render thread has to draw continuously until the next request.
+*/
+void RequestFrame(bool animating)
+{
+    {
+        std::lock_guard<std::mutex> lock(g_frameMutex);
+        g_framePending = true;
+        g_animating = animating;
+    }
+    g_frameRequest.notify_one();
+}
+
+/**
+* \brief Draws the states the update loop publishes until it is stopped; owns the OpenGL context meanwhile.
+* \param window The window to display our stuff in.
+* \param options Power saving: waits for a new state while nothing animates. Frame limit, vsync: as in RunCoreLoop.
+*/
+void RunRenderLoop(GLFWwindow* window, const GameOptions& options)
+{
+    glfwMakeContextCurrent(window);
+    glfwSwapInterval(options.vsync ? 1 : 0); // belongs to the context current on this thread
+
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(g_frameMutex);
+            if (options.powerSaving)
+                g_frameRequest.wait(lock, [] { return g_framePending || g_animating || !g_rendering; });
+            if (!g_rendering)
+                break;
+            g_framePending = false;
+        }
+
+        double frameStart = glfwGetTime();
+        int screenWidth = g_framebufferWidth;
+        int screenHeight = g_framebufferHeight;
+        glViewport(0, 0, screenWidth, screenHeight);
+        glEnable(GL_DEPTH_TEST);
+        glDepthFunc(GL_LEQUAL);
+        glClearColor(0.0f, 0.0f, 0.0f, 1.0f); // black color
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        if (!g_minimized && screenHeight > 0)
+        {
+            float aspectRatio = static_cast<float>(screenWidth) / static_cast<float>(screenHeight);
+            g_myInterface->RenderPublished(aspectRatio, frameStart);
+        }
+
+        glfwSwapBuffers(window);
+
+        if (options.maxFramesPerSecond > 0.0)
+        {
+            double remaining = frameStart + 1.0 / options.maxFramesPerSecond - glfwGetTime();
+            if (remaining > 0.0)
+                std::this_thread::sleep_for(std::chrono::duration<double>(remaining));
+        }
+    }
+
+    glfwMakeContextCurrent(nullptr);
+}
+
+/**
+* \brief Runs the core loop with drawing on a render thread of its own.
+* This thread handles the events, which GLFW only delivers on the main thread, and updates the game in fixed steps of
+* FIXED_TIME_STEP, publishing the state after each batch of updates. The render thread draws the last published state
+* at its own pace and never waits for an update, neither does an update wait for a frame.
+* \param window The window to display our stuff in.
+* \param options See RunCoreLoop.
+*/
+void RunThreadedCoreLoop(GLFWwindow* window, const GameOptions& options)
+{
+    glfwMakeContextCurrent(nullptr); // a context is current on one thread at a time
+    std::thread renderThread(RunRenderLoop, window, std::cref(options));
+
+    double lastTime = glfwGetTime();
+    double accumulator = FIXED_TIME_STEP; // simulated time still owed; the first pass updates once right away
+
+    while (!glfwWindowShouldClose(window))
+    {
+        if (options.powerSaving && !g_redrawRequested && !g_myInterface->IsAnimating())
+        {
+            glfwWaitEventsTimeout(IDLE_TIMEOUT);
+            if (!g_redrawRequested)
+                continue;
+            lastTime = glfwGetTime();
+            accumulator = FIXED_TIME_STEP;
+        }
+        else
+        {
+            double untilNextStep = FIXED_TIME_STEP - accumulator - (glfwGetTime() - lastTime);
+            if (untilNextStep > 0.0 && !g_redrawRequested)
+                glfwWaitEventsTimeout(untilNextStep); // input wakes up early, the step itself waits for its time
+            else
+                glfwPollEvents();
+        }
+        g_redrawRequested = false;
+
+        double now = glfwGetTime();
+        accumulator += std::min(now - lastTime, MAX_FRAME_TIME);
+        lastTime = now;
+        while (accumulator >= FIXED_TIME_STEP)
+        {
+            g_myInterface->Update(FIXED_TIME_STEP);
+            accumulator -= FIXED_TIME_STEP;
+        }
+
+        g_myInterface->Publish(now - accumulator); // the simulated time the last update reached
+        RequestFrame(g_myInterface->IsAnimating());
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(g_frameMutex);
+        g_rendering = false;
+    }
+    g_frameRequest.notify_one();
+    renderThread.join();
+    glfwMakeContextCurrent(window); // the resources are released on this thread
+}
+
+/**
+* \brief Plays the input log started with GameInterface::StartReplay back and prints the frame times.
+* Every frame runs exactly one update with the delta time of the recorded one, so the game goes through the same
+* states as when it was recorded, independent of how fast the frames are drawn. Nothing waits for input or a frame
+* limit; the window events are still handled, so closing it ends the replay early.
+* \param window The window to display our stuff in.
+*/
+void RunReplayLoop(GLFWwindow* window)
+{
+    std::vector<double> frameTimes;
+    double lastTime = glfwGetTime();
+    double start = lastTime;
+
+    for (double step = g_myInterface->GetReplayStep(); step >= 0.0 && !glfwWindowShouldClose(window); step = g_myInterface->GetReplayStep())
+    {
+        glfwPollEvents();
+        g_myInterface->Update(step);
+
+        int screenWidth, screenHeight;
+        glfwGetFramebufferSize(window, &screenWidth, &screenHeight);
+        glViewport(0, 0, screenWidth, screenHeight);
+        glEnable(GL_DEPTH_TEST);
+        glDepthFunc(GL_LEQUAL);
+        glClearColor(0.0f, 0.0f, 0.0f, 1.0f); // black color
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        if (screenHeight > 0)
+            g_myInterface->Render(static_cast<float>(screenWidth) / static_cast<float>(screenHeight), 1.0); // the state after the update
+        glfwSwapBuffers(window);
+
+        double now = glfwGetTime();
+        frameTimes.push_back(now - lastTime);
+        lastTime = now;
     }
+
+    if (frameTimes.empty())
+    {
+        std::cerr << "Replayed no frames" << std::endl;
+        return;
+    }
+    double total = lastTime - start;
+    std::sort(frameTimes.begin(), frameTimes.end());
+    auto percentile = [&frameTimes](double p) { return 1000.0 * frameTimes[static_cast<size_t>(p * (frameTimes.size() - 1) + 0.5)]; };
+    std::cerr << "Replayed " << frameTimes.size() << " frames in " << total << " s: mean " << 1000.0 * total / frameTimes.size()
+        << " ms, p50 " << percentile(0.5) << " ms, p95 " << percentile(0.95) << " ms, p99 " << percentile(0.99)
+        << " ms, max " << 1000.0 * frameTimes.back() << " ms" << std::endl;
+}
+
+/**
+* \brief Renders one image per scramble of the input file into the thumbnail directory, without showing a window.
+* The image of line n is named n.png; lines that are no valid scrambles are reported and skipped.
+* \return The exit code: 0 if all images were written.
+*/
+int RenderThumbnails(const GameOptions& options)
+{
+    std::ifstream input(options.thumbnailInput);
+    if (!input)
+    {
+        std::cerr << "Could not open " << options.thumbnailInput << std::endl;
+        return 1;
+    }
+    std::error_code error;
+    std::filesystem::create_directories(options.thumbnailDirectory, error);
+
+    // the window only provides the context, everything is drawn into framebuffer objects
+    GLFWwindow* window = CreateContextWindow(16, 16, false, false);
+    if (window == nullptr)
+        return 1;
+    glfwMakeContextCurrent(window);
+    glewExperimental = true;
+    glewInit();
+
+    ThreadPool pool;
+    CubeThumbnailRenderer renderer;
+    if (!renderer.Initialize(options.thumbnailSize, pool))
+    {
+        glfwTerminate();
+        return 1;
+    }
+
+    std::vector<CubeState> cubes;
+    std::vector<std::string> fileNames;
+    std::string line;
+    size_t lineNumber = 0, skippedCount = 0, imageCount = 0;
+    auto start = std::chrono::steady_clock::now();
+    while (input)
+    {
+        cubes.clear();
+        fileNames.clear();
+        while (cubes.size() < THUMBNAIL_CHUNK_SIZE && std::getline(input, line))
+        {
+            ++lineNumber;
+            CubeState cube;
+            MoveParser parser(line);
+            Move move;
+            while (parser.Next(move))
+                cube.ApplyMove(move);
+            if (parser.HasError())
+            {
+                std::cerr << "Line " << lineNumber << ": invalid move at column " << parser.GetPosition() + 1 << std::endl;
+                ++skippedCount;
+                continue;
+            }
+            cubes.push_back(cube);
+            fileNames.push_back((std::filesystem::path(options.thumbnailDirectory) / (std::to_string(lineNumber) + ".png")).string());
+        }
+        renderer.Render(cubes.data(), fileNames.data(), static_cast<int>(cubes.size()));
+        imageCount += cubes.size();
+    }
+    int failedCount = renderer.Finish();
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cerr << "Wrote " << imageCount - failedCount << " of " << lineNumber << " images in " << seconds << " s" << std::endl;
+
+    renderer.ClearResources();
+    glfwTerminate();
+    return skippedCount == 0 && failedCount == 0 ? 0 : 2;
 }
 
 /**
@@ -87,11 +475,84 @@ void ShutDownSystem()
     glfwTerminate();
 }
 
-int main()
+/**
+* \brief Reads the command line; prints the usage and returns false on unknown arguments.
+* By default the game only draws while something moves or after input; --continuous draws frames all the time.
+* --single-thread updates and draws on the main thread instead of drawing on a render thread.
+* --shaders reads the shaders from a directory and reloads them when they change, for working on them.
+* --thumbnails renders an image of every scramble in a file instead of starting the game, see RenderThumbnails.
+* --record writes the input into a log, which --replay plays back for measuring, see RunReplayLoop.
+*/
+bool ParseArguments(int argc, char** argv, GameOptions& options)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--continuous") == 0)
+            options.powerSaving = false;
+        else if (std::strcmp(argv[i], "--no-vsync") == 0)
+            options.vsync = false;
+        else if (std::strcmp(argv[i], "--max-fps") == 0 && i + 1 < argc)
+            options.maxFramesPerSecond = std::atof(argv[++i]);
+        else if (std::strcmp(argv[i], "--single-thread") == 0)
+            options.renderThread = false;
+        else if (std::strcmp(argv[i], "--thumbnails") == 0 && i + 2 < argc)
+        {
+            options.thumbnailInput = argv[++i];
+            options.thumbnailDirectory = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--thumbnail-size") == 0 && i + 1 < argc)
+            options.thumbnailSize = std::max(1, std::atoi(argv[++i]));
+        else if (std::strcmp(argv[i], "--shaders") == 0 && i + 1 < argc)
+            options.shaderDirectory = argv[++i];
+        else if (std::strcmp(argv[i], "--record") == 0 && i + 1 < argc)
+            options.recordFile = argv[++i];
+        else if (std::strcmp(argv[i], "--replay") == 0 && i + 1 < argc)
+            options.replayFile = argv[++i];
+        else if (std::strcmp(argv[i], "--headless") == 0)
+            options.headless = true;
+        else
+        {
+            std::cerr << "Usage: RubixCube [--continuous] [--no-vsync] [--max-fps n] [--single-thread] [--shaders directory] [--record file]\n"
+                "       RubixCube --replay file [--headless]\n"
+                "       RubixCube --thumbnails scrambles directory [--thumbnail-size n]" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char** argv)
 {
     g_myInterface = &g_testCompound;  // rotating cubies with different cubie colors
 
-    GLFWwindow* window = InitializeSystem();
-    RunCoreLoop(window);
+    GameOptions options;
+    if (!ParseArguments(argc, argv, options))
+        return 1;
+    ShaderUtil::SetSourceDirectory(options.shaderDirectory);
+    if (!options.thumbnailInput.empty())
+        return RenderThumbnails(options);
+
+    bool replay = !options.replayFile.empty();
+    GLFWwindow* window = InitializeSystem(options.vsync && !replay, !(replay && options.headless));
+    if (window == nullptr)
+        return 1;
+    if (!options.recordFile.empty() && !g_myInterface->StartRecording(options.recordFile.c_str()))
+    {
+        ShutDownSystem();
+        return 1;
+    }
+    if (replay)
+    {
+        if (!g_myInterface->StartReplay(options.replayFile.c_str()))
+        {
+            ShutDownSystem();
+            return 1;
+        }
+        RunReplayLoop(window);
+    }
+    else if (options.renderThread && g_myInterface->SupportsRenderThread())
+        RunThreadedCoreLoop(window, options);
+    else
+        RunCoreLoop(window, options);
     ShutDownSystem();
 }
@@ -0,0 +1,216 @@
+#include "ShaderManager.h"
+#include "ShaderUtil.h"
+#include <filesystem>
+#include <iostream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <cerrno>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+	long long GetModificationTime(const std::string& path)
+	{
+		std::error_code error;
+		auto time = std::filesystem::last_write_time(path, error);
+		return error ? 0 : static_cast<long long>(time.time_since_epoch().count());
+	}
+}
+
+void ShaderManager::Initialize()
+{
+	m_directory = ShaderUtil::GetSourceDirectory();
+	if (m_directory.empty())
+		return;
+
+	if (GLEW_KHR_parallel_shader_compile)
+		glMaxShaderCompilerThreadsKHR(0xFFFFFFFF); // as many as the driver likes
+	else if (GLEW_ARB_parallel_shader_compile)
+		glMaxShaderCompilerThreadsARB(0xFFFFFFFF);
+
+	m_stopping = false;
+#ifdef _WIN32
+	m_stopEvent = CreateEventA(nullptr, TRUE, FALSE, nullptr);
+#else
+	if (pipe(m_stopPipe) != 0)
+		m_stopPipe[0] = m_stopPipe[1] = -1;
+#endif
+	m_watcher = std::thread(&ShaderManager::WatchLoop, this);
+}
+
+GLuint ShaderManager::Load(const char* vertexFilename, const char* fragmentFilename, ReloadFunction onReload)
+{
+	Program program;
+	program.vertexFilename = vertexFilename;
+	program.fragmentFilename = fragmentFilename;
+	program.program = ShaderUtil::CreateShaderProgram(vertexFilename, fragmentFilename);
+	program.onReload = std::move(onReload);
+	m_programs.push_back(std::move(program));
+
+	Watch(vertexFilename);
+	Watch(fragmentFilename);
+	return m_programs.back().program;
+}
+
+void ShaderManager::Update()
+{
+	if (m_changed.exchange(false, std::memory_order_acquire))
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		for (WatchedFile& file : m_files)
+		{
+			if (!file.changed)
+				continue;
+			file.changed = false;
+			for (Program& program : m_programs)
+			{
+				if (program.vertexFilename != file.name && program.fragmentFilename != file.name)
+					continue;
+				if (program.pending != 0) // changed again while compiling, the newer sources win
+					glDeleteProgram(program.pending);
+				std::cout << "Reloading " << program.vertexFilename << " and " << program.fragmentFilename << std::endl;
+				program.pending = ShaderUtil::StartShaderProgram(program.vertexFilename.c_str(), program.fragmentFilename.c_str());
+			}
+		}
+	}
+
+	for (Program& program : m_programs)
+	{
+		if (program.pending == 0 || !ShaderUtil::IsProgramReady(program.pending))
+			continue;
+		GLuint built = program.pending;
+		program.pending = 0;
+		if (!ShaderUtil::FinishShaderProgram(built))
+		{
+			glDeleteProgram(built); // the old program stays in use
+			continue;
+		}
+		program.onReload(built);
+		glDeleteProgram(program.program);
+		program.program = built;
+	}
+}
+
+void ShaderManager::ClearResources()
+{
+	if (m_watcher.joinable())
+	{
+		m_stopping = true;
+#ifdef _WIN32
+		SetEvent(m_stopEvent);
+		m_watcher.join();
+		CloseHandle(m_stopEvent);
+		m_stopEvent = nullptr;
+#else
+		if (m_stopPipe[1] >= 0)
+			(void)write(m_stopPipe[1], "x", 1);
+		m_watcher.join();
+		for (int& end : m_stopPipe)
+		{
+			if (end >= 0)
+				close(end);
+			end = -1;
+		}
+#endif
+	}
+
+	for (Program& program : m_programs)
+	{
+		if (program.pending != 0)
+			glDeleteProgram(program.pending);
+	}
+	m_programs.clear();
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_files.clear();
+}
+
+void ShaderManager::Watch(const std::string& fileName)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	for (const WatchedFile& file : m_files)
+	{
+		if (file.name == fileName)
+			return;
+	}
+	WatchedFile file;
+	file.name = fileName;
+	file.modified = GetModificationTime((std::filesystem::path(m_directory) / fileName).string());
+	m_files.push_back(file);
+}
+
+bool ShaderManager::CheckFiles()
+{
+	bool changed = false;
+	std::lock_guard<std::mutex> lock(m_mutex);
+	for (WatchedFile& file : m_files)
+	{
+		long long modified = GetModificationTime((std::filesystem::path(m_directory) / file.name).string());
+		if (modified != 0 && modified != file.modified) // 0 while an editor replaces the file
+		{
+			file.modified = modified;
+			file.changed = true;
+			changed = true;
+		}
+	}
+	return changed;
+}
+
+void ShaderManager::WatchLoop()
+{
+#ifdef _WIN32
+	HANDLE change = FindFirstChangeNotificationA(m_directory.c_str(), FALSE, FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME);
+	if (change == INVALID_HANDLE_VALUE)
+	{
+		std::cerr << "Could not watch " << m_directory << " for shader changes" << std::endl;
+		return;
+	}
+	HANDLE handles[2] = { change, m_stopEvent };
+	while (!m_stopping)
+	{
+		if (WaitForMultipleObjects(2, handles, FALSE, INFINITE) != WAIT_OBJECT_0)
+			break;
+		if (CheckFiles())
+			m_changed.store(true, std::memory_order_release);
+		FindNextChangeNotification(change);
+	}
+	FindCloseChangeNotification(change);
+#else
+	int notifications = inotify_init1(IN_CLOEXEC);
+	if (notifications < 0 || inotify_add_watch(notifications, m_directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE) < 0)
+	{
+		std::cerr << "Could not watch " << m_directory << " for shader changes" << std::endl;
+		if (notifications >= 0)
+			close(notifications);
+		return;
+	}
+	pollfd descriptors[2] = { { notifications, POLLIN, 0 }, { m_stopPipe[0], POLLIN, 0 } };
+	char events[4096];
+	while (!m_stopping)
+	{
+		if (poll(descriptors, 2, -1) < 0)
+		{
+			if (errno == EINTR) // a signal, e.g. of a debugger or profiler, is no reason to stop watching
+				continue;
+			std::cerr << "Stopped watching " << m_directory << " for shader changes" << std::endl;
+			break;
+		}
+		if ((descriptors[1].revents & POLLIN) != 0)
+			break;
+		if (read(notifications, events, sizeof(events)) < 0 && errno != EINTR) // which files does not matter, CheckFiles looks at all
+		{
+			std::cerr << "Stopped watching " << m_directory << " for shader changes" << std::endl;
+			break;
+		}
+		if (CheckFiles())
+			m_changed.store(true, std::memory_order_release);
+	}
+	close(notifications);
+#endif
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include <GL/glew.h>
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Reloads shader programs while the game runs. A watcher thread sleeps until the operating system reports a change in
+// the shader directory (inotify, change notifications on Windows) and then compares the modification times of the
+// watched files; nothing is checked during a frame unless that happened. Changed programs are rebuilt from Update,
+// without waiting for the driver if it compiles in parallel (KHR_parallel_shader_compile), and only replace the old
+// program once they linked; a program that fails keeps the old one in use.
+class ShaderManager
+{
+public:
+	// receives the new program after a reload, e.g. to look up its uniform locations; the old one is deleted afterwards
+	typedef std::function<void(GLuint)> ReloadFunction;
+
+	// watches the directory of ShaderUtil::GetSourceDirectory; embedded sources never change, nothing is watched then
+	void Initialize();
+	// creates the program like ShaderUtil::CreateShaderProgram and rebuilds it whenever one of the files changes
+	GLuint Load(const char* vertexFilename, const char* fragmentFilename, ReloadFunction onReload);
+	void Update(); // on the thread of the OpenGL context, once per frame
+	void ClearResources(); // stops watching; the programs belong to the callers
+
+private:
+	struct Program
+	{
+		std::string vertexFilename;
+		std::string fragmentFilename;
+		GLuint program = 0;
+		GLuint pending = 0; // being rebuilt
+		ReloadFunction onReload;
+	};
+
+	struct WatchedFile
+	{
+		std::string name;
+		long long modified = 0; // ticks of std::filesystem::file_time_type
+		bool changed = false;
+	};
+
+	void Watch(const std::string& fileName);
+	void WatchLoop();
+	bool CheckFiles(); // true if a watched file was modified; on the watcher thread
+
+	std::string m_directory;
+	std::vector<Program> m_programs;
+	std::mutex m_mutex;                    // guards m_files
+	std::vector<WatchedFile> m_files;
+	std::atomic<bool> m_changed{ false };  // a file is marked changed
+	std::atomic<bool> m_stopping{ false };
+	std::thread m_watcher;
+#ifdef _WIN32
+	void* m_stopEvent = nullptr;
+#else
+	int m_stopPipe[2] = { -1, -1 };
+#endif
+};
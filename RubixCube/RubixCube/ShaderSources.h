@@ -0,0 +1,125 @@
+#pragma once
+#include <string_view>
+
+// Generated by EmbedShaders.ps1 from the *.glsl files before every build, do not edit.
+namespace ShaderSources
+{
+	struct Source
+	{
+		std::string_view fileName;
+		std::string_view text;
+	};
+
+	constexpr Source ALL[] =
+	{
+		{ "FragmentShaderColor.glsl", R"glsl(#version 330
+
+in vec3 vertColor;
+out vec4 color;
+
+void main()
+{
+	color = vec4(vertColor, 1.0);
+})glsl" },
+		{ "FragmentShaderSimple.glsl", R"glsl(#version 330
+
+out vec4 color; // Vertex Shader braucht genau eine Ausgangsvariable nmlich Farbe
+
+void main()
+{
+	color = vec4(1.0, 0.0, 0.0, 1.0);
+}
+)glsl" },
+		{ "VertexShaderColor.glsl", R"glsl(#version 330
+
+layout(std140) uniform Camera
+{
+	mat4 viewProjection;
+};
+uniform mat4 model; // placement of the cubie in the world
+
+layout(location = 0) in vec3 position;
+layout(location = 1) in vec3 inColor;
+
+out vec3 vertColor;
+
+void main()
+{
+	gl_Position = viewProjection * model * vec4(position, 1.0);
+	vertColor = inColor;
+})glsl" },
+		{ "VertexShaderInstanced.glsl", R"glsl(#version 330
+
+layout(std140) uniform Camera
+{
+	mat4 viewProjection;
+};
+uniform mat4 model; // orientation of the whole cube
+
+layout(location = 0) in vec3 position;
+layout(location = 1) in vec3 inColor;
+layout(location = 2) in mat4 cubieTransformation; // per instance, occupies the locations 2 to 5
+
+out vec3 vertColor;
+
+void main()
+{
+	gl_Position = viewProjection * (model * (cubieTransformation * vec4(position, 1.0)));
+	vertColor = inColor;
+})glsl" },
+		{ "VertexShaderScene.glsl", R"glsl(#version 330
+
+layout(std140) uniform Camera
+{
+	mat4 viewProjection; // the cubes themselves are not rotated
+};
+
+layout(location = 0) in vec3 position;
+layout(location = 1) in vec3 inColor;
+layout(location = 2) in vec3 cubieCenter; // per instance, in world space
+layout(location = 3) in vec3 rotationX;   // per instance: the columns of the cubie rotation
+layout(location = 4) in vec3 rotationY;
+layout(location = 5) in vec3 rotationZ;
+
+out vec3 vertColor;
+
+void main()
+{
+	gl_Position = viewProjection * vec4(cubieCenter + mat3(rotationX, rotationY, rotationZ) * position, 1.0);
+	vertColor = inColor;
+})glsl" },
+		{ "VertexShaderSimple.glsl", R"glsl(#version 330
+
+uniform mat4 transformation; // uniform variables act as constants, at least for the duration of a draw call
+
+layout(location = 0) in vec3 position;
+
+void main()
+{
+	gl_Position = transformation * vec4(position, 1.0f); // Ausgabeposition von Vertex
+})glsl" },
+		{ "VertexShaderSticker.glsl", R"glsl(#version 330
+
+layout(std140) uniform Camera
+{
+	mat4 viewProjection; // the cubes themselves are not rotated
+};
+uniform vec3 faceColors[6];         // in face order U R F D L B
+uniform usamplerBuffer faceletFaces; // per cube the face whose color each of the 54 facelets shows
+
+layout(location = 0) in vec3 position;
+layout(location = 1) in int facelet;       // face * 9 + index on the face, -1 for the black body
+layout(location = 2) in vec3 cubePosition; // per instance
+
+out vec3 vertColor;
+
+void main()
+{
+	gl_Position = viewProjection * vec4(cubePosition + position, 1.0);
+	if (facelet < 0)
+		vertColor = vec3(0.05);
+	else
+		vertColor = faceColors[texelFetch(faceletFaces, gl_InstanceID * 54 + facelet).r];
+})glsl" },
+	};
+}
@@ -1,73 +1,226 @@
 #include "ShaderUtil.h"
+#include "ShaderSources.h"
+#include "TableFile.h"
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
 #include <iostream>
 #include <fstream> // file stream  
+#include <sstream>
+#include <vector>
+
+namespace
+{
+    // a cheap check of the embedded sources while compiling: a version line, a main function and balanced brackets
+    constexpr bool IsPlausibleShader(std::string_view text)
+    {
+        if (text.substr(0, 9) != "#version " || text.find("void main()") == std::string_view::npos)
+            return false;
+        int braces = 0, parentheses = 0;
+        for (std::size_t i = 0; i < text.size(); ++i)
+        {
+            if (text.substr(i, 2) == "//")                          // brackets in comments do not count
+                i = text.find('\n', i) == std::string_view::npos ? text.size() : text.find('\n', i);
+            else if (text.substr(i, 2) == "/*")
+                i = text.find("*/", i) == std::string_view::npos ? text.size() : text.find("*/", i) + 1;
+            else if (text[i] == '{')
+                ++braces;
+            else if (text[i] == '}')
+                --braces;
+            else if (text[i] == '(')
+                ++parentheses;
+            else if (text[i] == ')')
+                --parentheses;
+            if (braces < 0 || parentheses < 0)
+                return false;
+        }
+        return braces == 0 && parentheses == 0;
+    }
+
+    constexpr bool AreEmbeddedShadersPlausible()
+    {
+        for (const ShaderSources::Source& source : ShaderSources::ALL)
+        {
+            if (!IsPlausibleShader(source.text))
+                return false;
+        }
+        return true;
+    }
+
+    static_assert(AreEmbeddedShadersPlausible(), "an embedded shader is broken, see the *.glsl files and EmbedShaders.ps1");
+}
+
+std::string ShaderUtil::s_sourceDirectory;
 
 GLuint ShaderUtil::CreateShaderProgram(const char* vertexFilename, const char* fragmentFilename) // Create shader program from vertex and fragment shader files
 {
     std::string vertexProgram = LoadFile(vertexFilename);           // Load vertex shader source code from file
-    const char* vertexString = vertexProgram.c_str();               // Get C-string pointer from std::string
-    GLuint vertexShader = glCreateShader(GL_VERTEX_SHADER);         // Create a vertex shader object
-    glShaderSource(vertexShader, 1, &vertexString, NULL);           // Attach source code to vertex shader
+    std::string fragmentProgram = LoadFile(fragmentFilename);
+    std::string cachePath = GetCachePath(vertexProgram, fragmentProgram); // empty if the driver can not hand out program binaries
+    if (!cachePath.empty())
+    {
+        GLuint cachedProgram = LoadCachedProgram(cachePath);       // linked by an earlier start, no compiling needed
+        if (cachedProgram != 0)
+            return cachedProgram;
+    }
+
+    GLuint shaderProgram = CompileAndLink(vertexProgram, fragmentProgram, !cachePath.empty());
+    if (FinishShaderProgram(shaderProgram) && !cachePath.empty())
+        StoreCachedProgram(shaderProgram, cachePath);
+    return shaderProgram;                                           // Return the linked shader program ID
+}
+
+GLuint ShaderUtil::StartShaderProgram(const char* vertexFilename, const char* fragmentFilename)
+{
+    return CompileAndLink(LoadFile(vertexFilename), LoadFile(fragmentFilename), false);
+}
 
-    PrintOGlErrors();                                               // Print any OpenGL errors before compiling
-    glCompileShader(vertexShader);                                  // Compile the vertex shader
-    PrintOGlErrors();                                               // Print any OpenGL errors after compiling
-    int vertCompiled;                                               // Variable to hold compilation status
-    glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &vertCompiled);  // Get compile status of vertex shader
-    if (vertCompiled != 1)                                          // Check if vertex shader compiled successfully
+bool ShaderUtil::IsProgramReady(GLuint program)
+{
+    if (!GLEW_KHR_parallel_shader_compile && !GLEW_ARB_parallel_shader_compile)
+        return true;                                               // the driver compiled while linking, nothing to wait for
+    int completed;
+    glGetProgramiv(program, GL_COMPLETION_STATUS_KHR, &completed); // the same value as GL_COMPLETION_STATUS_ARB
+    return completed != 0;
+}
+
+bool ShaderUtil::FinishShaderProgram(GLuint program)
+{
+    int linked;
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);               // Get link status of shader program
+    if (linked == 1)
+        return true;
+
+    GLuint shaders[2];
+    GLsizei shaderCount = 0;
+    glGetAttachedShaders(program, 2, &shaderCount, shaders);       // still attached, deleting them only flagged them
+    for (GLsizei i = 0; i < shaderCount; ++i)
     {
-        std::cout << "Vertex shader error " << std::endl;
-        PrintShaderLog(vertexShader);
+        int compiled, type;
+        glGetShaderiv(shaders[i], GL_COMPILE_STATUS, &compiled);   // Get compile status of the shader
+        glGetShaderiv(shaders[i], GL_SHADER_TYPE, &type);
+        if (compiled != 1)
+        {
+            std::cout << (type == GL_VERTEX_SHADER ? "Vertex" : "Fragment") << " shader error " << std::endl;
+            PrintShaderLog(shaders[i]);
+        }
     }
+    std::cout << "Linking failed:" << std::endl;
+    PrintProgramLog(program);
+    PrintOGlErrors();                                               // only on failure, every glGetError may stall the driver
+    return false;
+}
+
+GLuint ShaderUtil::CompileAndLink(const std::string& vertexProgram, const std::string& fragmentProgram, bool retrievable)
+{
+    const char* vertexString = vertexProgram.c_str();               // Get C-string pointer from std::string
+    GLuint vertexShader = glCreateShader(GL_VERTEX_SHADER);         // Create a vertex shader object
+    glShaderSource(vertexShader, 1, &vertexString, NULL);           // Attach source code to vertex shader
+    glCompileShader(vertexShader);                                  // Compile the vertex shader, the status is checked after linking
 
-    std::string fragmentProgram = LoadFile(fragmentFilename);
     const char* fragmentString = fragmentProgram.c_str();
     GLuint fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
     glShaderSource(fragmentShader, 1, &fragmentString, NULL);
-
-    PrintOGlErrors();
     glCompileShader(fragmentShader);
-    PrintOGlErrors();
-    int fragCompiled;
-    glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &fragCompiled);
-    if (fragCompiled != 1)
-    {
-        std::cout << "Fragment shader error " << std::endl;
-        PrintShaderLog(fragmentShader);
-    }
 
     GLuint shaderProgram = glCreateProgram();                       // Create a shader program object
     glAttachShader(shaderProgram, vertexShader);                    // Attach vertex shader to program
     glAttachShader(shaderProgram, fragmentShader);                  // Attach fragment shader to program
+    if (retrievable)
+        glProgramParameteri(shaderProgram, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE); // keep the binary around for the cache
     glLinkProgram(shaderProgram);                                   // Link the shader program
-    PrintOGlErrors();
+
+    // Optimization: the shaders are not relevant anymore => delete them; they go with the program they are attached to
+    glDeleteShader(vertexShader);
+    glDeleteShader(fragmentShader);
+
+    return shaderProgram;
+}
+
+std::string ShaderUtil::GetCachePath(const std::string& vertexProgram, const std::string& fragmentProgram)
+{
+    GLint formatCount = 0;
+    if (GLEW_ARB_get_program_binary)
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+    if (formatCount == 0)
+        return std::string();
+
+    // a binary only fits the sources and the driver it was made from, so both go into the name of the file
+    const char* driver[3] = { reinterpret_cast<const char*>(glGetString(GL_VENDOR)), reinterpret_cast<const char*>(glGetString(GL_RENDERER)),
+        reinterpret_cast<const char*>(glGetString(GL_VERSION)) };
+    std::uint64_t hash = 0xcbf29ce484222325ull;                    // FNV-1a
+    auto add = [&hash](const char* text, std::size_t length)
+    {
+        for (std::size_t i = 0; i < length; ++i)
+            hash = (hash ^ static_cast<unsigned char>(text[i])) * 0x100000001b3ull;
+        hash = (hash ^ 0xFF) * 0x100000001b3ull;                    // separator, so that moving text between parts changes the hash
+    };
+    add(vertexProgram.data(), vertexProgram.size());
+    add(fragmentProgram.data(), fragmentProgram.size());
+    for (const char* part : driver)
+        add(part != nullptr ? part : "", part != nullptr ? std::strlen(part) : 0);
+
+    char name[17];
+    std::snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(hash));
+    return std::string(CACHE_DIRECTORY) + "/" + name + ".bin";
+}
+
+GLuint ShaderUtil::LoadCachedProgram(const std::string& cachePath)
+{
+    TableFile file;                                                // binary format followed by the binary itself
+    if (!file.Map(cachePath, CACHE_VERSION, TableFile::ANY_SIZE, true) || file.GetSize() <= sizeof(GLenum))
+        return 0;
+
+    GLenum format;
+    std::memcpy(&format, file.GetData(), sizeof(format));
+    GLuint program = glCreateProgram();
+    glProgramBinary(program, format, file.GetData() + sizeof(format), static_cast<GLsizei>(file.GetSize() - sizeof(format)));
     int linked;
-    glGetProgramiv(shaderProgram, GL_LINK_STATUS, &linked);         // Get link status of shader program
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);              // false if the driver no longer accepts the binary
     if (linked != 1)
     {
-        std::cout << "Linking failed:" << std::endl;
-        PrintProgramLog(shaderProgram);
+        glDeleteProgram(program);
+        return 0;
     }
+    return program;
+}
 
-    // Optimization: the shaders are not relevant anymore => delete them
-    glDeleteShader(vertexShader);                                  // Delete vertex shader object (no longer needed)
-    glDeleteShader(fragmentShader);                                // Delete fragment shader object (no longer needed)
+void ShaderUtil::StoreCachedProgram(GLuint program, const std::string& cachePath)
+{
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+        return;
 
-    return shaderProgram;                                          // Return the linked shader program ID
+    std::vector<std::uint8_t> data(sizeof(GLenum) + length);
+    GLenum format = 0;
+    GLsizei written = 0;
+    glGetProgramBinary(program, length, &written, &format, data.data() + sizeof(format));
+    std::memcpy(data.data(), &format, sizeof(format));
+    TableFile::Write(cachePath, CACHE_VERSION, data.data(), sizeof(format) + written); // a failure only costs the next start a compile
 }
 
 std::string ShaderUtil::LoadFile(const char* fileName)             // Load the content of a file into a std::string
 {
-    std::string result;                                            // String to accumulate file contents
-    std::ifstream fileStream(fileName, std::ios::in);              // Open file stream for reading
-    while (!fileStream.eof())
+    if (s_sourceDirectory.empty())
+    {
+        for (const ShaderSources::Source& source : ShaderSources::ALL) // embedded at build time, no file access
+        {
+            if (source.fileName == fileName)
+                return std::string(source.text);
+        }
+    }
+
+    std::string path = s_sourceDirectory.empty() ? std::string(fileName) : s_sourceDirectory + "/" + fileName;
+    std::ifstream fileStream(path, std::ios::in | std::ios::binary); // Open file stream for reading
+    if (!fileStream)
     {
-        std::string line;
-        std::getline(fileStream, line);                            // Read a line from file
-        result.append(line + "\n");
+        std::cout << "Could not open shader " << path << std::endl;
+        return std::string();
     }
-    fileStream.close();
-    return result;
+    std::ostringstream result;                                     // the whole file at once, exactly as it is
+    result << fileStream.rdbuf();
+    return result.str();
 }
 
 void ShaderUtil::PrintShaderLog(GLuint shader)                     // Print the info log of a shader object
@@ -1,14 +1,39 @@
 #pragma once
 #include <GL/glew.h>
+#include <cstdint>
 #include <string>
 
+// Compiles and links shader programs. Linked programs are cached on disk as driver specific binaries, so later starts
+// skip compiling; a binary the driver rejects, e.g. after an update, is compiled from source again.
+// The sources are embedded into the program at build time (ShaderSources.h); for working on the shaders they can be
+// read from a directory instead, see SetSourceDirectory.
 class ShaderUtil
 {
 public:
+    static constexpr const char* CACHE_DIRECTORY = "ShaderCache";
+
     static GLuint CreateShaderProgram(const char* vertexFilename, const char* fragmentFilename);
 
+    // empty (the default): the embedded sources, else the *.glsl files in this directory
+    static void SetSourceDirectory(const std::string& directory) { s_sourceDirectory = directory; }
+    static const std::string& GetSourceDirectory() { return s_sourceDirectory; }
+
+    // Starts building a program from source without waiting for the driver; with KHR_parallel_shader_compile it
+    // compiles on threads of its own until IsProgramReady. FinishShaderProgram prints the errors and returns whether
+    // the program linked; it waits for the driver if the program is not ready yet.
+    static GLuint StartShaderProgram(const char* vertexFilename, const char* fragmentFilename);
+    static bool IsProgramReady(GLuint program);
+    static bool FinishShaderProgram(GLuint program);
+
 private:
+    static const std::uint32_t CACHE_VERSION = 1;
+    static std::string s_sourceDirectory;
+
     static std::string LoadFile(const char* fileName);
+    static GLuint CompileAndLink(const std::string& vertexProgram, const std::string& fragmentProgram, bool retrievable);
+    static std::string GetCachePath(const std::string& vertexProgram, const std::string& fragmentProgram);
+    static GLuint LoadCachedProgram(const std::string& cachePath); // 0 if there is no usable binary
+    static void StoreCachedProgram(GLuint program, const std::string& cachePath);
     static void PrintShaderLog(GLuint shader);
     static void PrintProgramLog(GLuint program);
     static void PrintOGlErrors();
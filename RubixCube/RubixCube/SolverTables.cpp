@@ -0,0 +1,17 @@
+#include "SolverTables.h"
+#include <iostream>
+
+std::shared_ptr<TableFile> SolverTables::LoadPruningTable(const std::string& path, std::uint32_t version, std::size_t entries,
+	const std::function<void(PruningTable)>& generate)
+{
+	return TableFile::LoadOrBuild(path, version, PruningTable::GetByteSize(entries), [&](std::uint8_t* data)
+		{
+			std::cout << "Generating " << path << std::endl;
+			generate(PruningTable(data, entries));
+		});
+}
+
+void SolverTables::PrintProgress(int depth, std::size_t filled, std::size_t size)
+{
+	std::cout << "  depth " << depth << ": " << filled << " / " << size << std::endl;
+}
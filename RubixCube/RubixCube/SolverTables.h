@@ -0,0 +1,53 @@
+#pragma once
+#include "CubeState.h"
+#include "PruningTable.h"
+#include "TableFile.h"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+// Loading and building of the tables the solvers share: files are mapped if they are valid, otherwise the
+// table is built and written so that the next start can map it.
+class SolverTables
+{
+public:
+	static constexpr const char* DEFAULT_DIRECTORY = "PruningTables";
+
+	typedef int (*GetCoordinate)(const CubeState&);
+	typedef void (*SetCoordinate)(CubeState&, int);
+
+	// [coordinate * moveCount + i] is the coordinate after applying moves[i]; T has to hold count - 1
+	template <typename T>
+	static std::shared_ptr<TableFile> LoadMoveTable(const std::string& path, std::uint32_t version, int count,
+		GetCoordinate get, SetCoordinate set, const Move* moves, int moveCount);
+
+	// generate fills a cleared table of the given number of entries, usually through PruningTableGenerator
+	static std::shared_ptr<TableFile> LoadPruningTable(const std::string& path, std::uint32_t version, std::size_t entries,
+		const std::function<void(PruningTable)>& generate);
+
+	static void PrintProgress(int depth, std::size_t filled, std::size_t size); // for PruningTableGenerator
+};
+
+template <typename T>
+std::shared_ptr<TableFile> SolverTables::LoadMoveTable(const std::string& path, std::uint32_t version, int count,
+	GetCoordinate get, SetCoordinate set, const Move* moves, int moveCount)
+{
+	std::size_t size = static_cast<std::size_t>(count) * moveCount * sizeof(T);
+	return TableFile::LoadOrBuild(path, version, size, [&](std::uint8_t* data)
+		{
+			T* table = reinterpret_cast<T*>(data);
+			for (int coordinate = 0; coordinate < count; ++coordinate)
+			{
+				CubeState cube;
+				set(cube, coordinate);
+				for (int i = 0; i < moveCount; ++i)
+				{
+					CubeState moved = cube;
+					moved.ApplyMove(moves[i]);
+					table[static_cast<std::size_t>(coordinate) * moveCount + i] = static_cast<T>(get(moved));
+				}
+			}
+		});
+}
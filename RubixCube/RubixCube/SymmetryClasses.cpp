@@ -0,0 +1,26 @@
+#include "SymmetryClasses.h"
+#include "CubeSymmetry.h"
+
+SymmetryClasses::SymmetryClasses(int count, SolverTables::GetCoordinate get, SolverTables::SetCoordinate set, int symmetryCount)
+	: m_symmetryCount(symmetryCount), m_classes(count, UINT32_MAX), m_symmetries(count, 0)
+{
+	for (int coordinate = 0; coordinate < count; ++coordinate)
+	{
+		if (m_classes[coordinate] != UINT32_MAX)
+			continue;
+
+		// the first coordinate of a new class represents it, every conjugate is mapped back onto it by the inverse
+		std::uint32_t classIndex = static_cast<std::uint32_t>(m_representatives.size());
+		m_representatives.push_back(static_cast<std::uint32_t>(coordinate));
+		CubeState cube;
+		set(cube, coordinate);
+		for (int symmetry = 0; symmetry < symmetryCount; ++symmetry)
+		{
+			int conjugate = get(CubeSymmetry::Conjugate(cube, symmetry));
+			if (m_classes[conjugate] != UINT32_MAX)
+				continue;
+			m_classes[conjugate] = classIndex;
+			m_symmetries[conjugate] = static_cast<std::uint8_t>(CubeSymmetry::Inverse(symmetry));
+		}
+	}
+}
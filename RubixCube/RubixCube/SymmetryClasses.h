@@ -0,0 +1,28 @@
+#pragma once
+#include "SolverTables.h"
+#include <cstdint>
+#include <vector>
+
+// Splits the values of a coordinate into classes of values that are conjugate to each other under the first
+// symmetryCount symmetries of CubeSymmetry (16 keep the U-D axis, 48 is the full group). Tables indexed by the
+// class instead of the raw coordinate are about symmetryCount times smaller. The coordinate has to be closed
+// under conjugation, like the corner or edge permutation.
+class SymmetryClasses
+{
+public:
+	SymmetryClasses(int count, SolverTables::GetCoordinate get, SolverTables::SetCoordinate set, int symmetryCount);
+
+	int GetSymmetryCount() const { return m_symmetryCount; }
+	int GetClassCount() const { return static_cast<int>(m_representatives.size()); }
+
+	int GetClass(int coordinate) const { return static_cast<int>(m_classes[coordinate]); }
+	// symmetry that conjugates a cube with this coordinate onto the representative of its class
+	int GetSymmetry(int coordinate) const { return m_symmetries[coordinate]; }
+	int GetRepresentative(int classIndex) const { return static_cast<int>(m_representatives[classIndex]); }
+
+private:
+	int m_symmetryCount;
+	std::vector<std::uint32_t> m_classes;         // [coordinate]
+	std::vector<std::uint8_t> m_symmetries;       // [coordinate]
+	std::vector<std::uint32_t> m_representatives; // [class], the smallest coordinate of the class
+};
@@ -0,0 +1,214 @@
+#include "TableFile.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+	const char MAGIC[8] = { 'R', 'C', 'T', 'A', 'B', 'L', 'E', '\0' };
+	const std::uint32_t FORMAT_VERSION = 1;
+
+	struct TableFileHeader
+	{
+		char magic[8];
+		std::uint32_t formatVersion;
+		std::uint32_t tableVersion;
+		std::uint64_t size;
+		std::uint64_t checksum;
+		std::uint8_t padding[32]; // keeps the table data 64 byte aligned inside the mapping
+	};
+	static_assert(sizeof(TableFileHeader) == 64, "table data has to start at a 64 byte boundary");
+
+	std::uint64_t Checksum(const std::uint8_t* data, std::size_t size) // FNV-1a over 64 bit words
+	{
+		const std::uint64_t prime = 0x100000001b3ull;
+		std::uint64_t hash = 0xcbf29ce484222325ull;
+		std::size_t i = 0;
+		for (; i + 8 <= size; i += 8)
+		{
+			std::uint64_t word;
+			std::memcpy(&word, data + i, 8);
+			hash = (hash ^ word) * prime;
+		}
+		for (; i < size; ++i)
+			hash = (hash ^ data[i]) * prime;
+		return hash;
+	}
+}
+
+TableFile::~TableFile()
+{
+	Unmap();
+}
+
+bool TableFile::Map(const std::string& path, std::uint32_t version, std::size_t size, bool verify)
+{
+	Unmap();
+
+#ifdef _WIN32
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+	m_file = file;
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize))
+	{
+		Unmap();
+		return false;
+	}
+	if (size == ANY_SIZE)
+		size = static_cast<std::uint64_t>(fileSize.QuadPart) > sizeof(TableFileHeader) ? static_cast<std::size_t>(fileSize.QuadPart) - sizeof(TableFileHeader) : 0;
+	if (static_cast<std::uint64_t>(fileSize.QuadPart) != sizeof(TableFileHeader) + size)
+	{
+		Unmap();
+		return false;
+	}
+	m_mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (m_mapping == nullptr)
+	{
+		Unmap();
+		return false;
+	}
+	m_view = static_cast<const std::uint8_t*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+	if (m_view == nullptr)
+	{
+		Unmap();
+		return false;
+	}
+#else
+	m_file = open(path.c_str(), O_RDONLY);
+	if (m_file < 0)
+		return false;
+	struct stat fileStatus;
+	if (fstat(m_file, &fileStatus) != 0)
+	{
+		Unmap();
+		return false;
+	}
+	if (size == ANY_SIZE)
+		size = static_cast<std::uint64_t>(fileStatus.st_size) > sizeof(TableFileHeader) ? static_cast<std::size_t>(fileStatus.st_size) - sizeof(TableFileHeader) : 0;
+	if (static_cast<std::uint64_t>(fileStatus.st_size) != sizeof(TableFileHeader) + size)
+	{
+		Unmap();
+		return false;
+	}
+	void* view = mmap(nullptr, sizeof(TableFileHeader) + size, PROT_READ, MAP_SHARED, m_file, 0);
+	if (view == MAP_FAILED)
+	{
+		Unmap();
+		return false;
+	}
+	m_view = static_cast<const std::uint8_t*>(view);
+#endif
+	m_viewSize = sizeof(TableFileHeader) + size;
+
+	TableFileHeader header;
+	std::memcpy(&header, m_view, sizeof(header));
+	const std::uint8_t* data = m_view + sizeof(TableFileHeader);
+	if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.formatVersion != FORMAT_VERSION
+		|| header.tableVersion != version || header.size != size || (verify && header.checksum != Checksum(data, size)))
+	{
+		Unmap();
+		return false;
+	}
+
+	m_data = data;
+	m_size = size;
+	return true;
+}
+
+void TableFile::Unmap()
+{
+#ifdef _WIN32
+	if (m_view != nullptr)
+		UnmapViewOfFile(m_view);
+	if (m_mapping != nullptr)
+		CloseHandle(m_mapping);
+	if (m_file != nullptr)
+		CloseHandle(m_file);
+	m_mapping = nullptr;
+	m_file = nullptr;
+#else
+	if (m_view != nullptr)
+		munmap(const_cast<std::uint8_t*>(m_view), m_viewSize);
+	if (m_file >= 0)
+		close(m_file);
+	m_file = -1;
+#endif
+	m_view = nullptr;
+	m_viewSize = 0;
+	m_data = nullptr;
+	m_size = 0;
+	m_buffer.clear();
+}
+
+bool TableFile::Write(const std::string& path, std::uint32_t version, const void* data, std::size_t size)
+{
+	TableFileHeader header = {};
+	std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+	header.formatVersion = FORMAT_VERSION;
+	header.tableVersion = version;
+	header.size = size;
+	header.checksum = Checksum(static_cast<const std::uint8_t*>(data), size);
+
+	std::error_code error;
+	std::filesystem::path target(path);
+	if (target.has_parent_path())
+		std::filesystem::create_directories(target.parent_path(), error);
+
+	// write to a temporary file first so that other processes never map a half written table
+	std::string temporaryPath = path + "." + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()) + ".tmp";
+	{
+		std::ofstream stream(temporaryPath, std::ios::binary | std::ios::trunc);
+		stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		stream.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+		if (!stream)
+		{
+			stream.close();
+			std::remove(temporaryPath.c_str());
+			return false;
+		}
+	}
+
+	std::filesystem::rename(temporaryPath, target, error);
+	if (error)
+	{
+		std::remove(temporaryPath.c_str());
+		return false;
+	}
+	return true;
+}
+
+std::shared_ptr<TableFile> TableFile::LoadOrBuild(const std::string& path, std::uint32_t version, std::size_t size,
+	const std::function<void(std::uint8_t*)>& build)
+{
+	auto table = std::make_shared<TableFile>();
+	if (table->Map(path, version, size))
+		return table;
+
+	std::vector<std::uint8_t> buffer(size, 0);
+	build(buffer.data());
+	Write(path, version, buffer.data(), size); // may fail if another process replaced the file meanwhile
+	if (table->Map(path, version, size, true))
+		return table;
+
+	std::cout << "Could not write table file " << path << ", keeping the table in memory" << std::endl;
+	table->m_buffer = std::move(buffer);
+	table->m_data = table->m_buffer.data();
+	table->m_size = size;
+	return table;
+}
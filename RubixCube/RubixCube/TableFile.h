@@ -0,0 +1,50 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Binary file holding one precomputed table behind a header with format version, table version, size and checksum.
+// Valid files are memory mapped read-only, so several processes share the same pages in the page cache.
+class TableFile
+{
+public:
+	TableFile() = default;
+	~TableFile();
+	TableFile(const TableFile&) = delete;
+	TableFile& operator=(const TableFile&) = delete;
+
+	static const std::size_t ANY_SIZE = ~static_cast<std::size_t>(0); // for Map: the size is taken from the file
+
+	// maps the file; fails if it is missing or was written for another version or size. Reading the whole table for
+	// the checksum would touch every page of the mapping, so it is only compared with verify.
+	bool Map(const std::string& path, std::uint32_t version, std::size_t size, bool verify = false);
+
+	const std::uint8_t* GetData() const { return m_data; }
+	std::size_t GetSize() const { return m_size; }
+
+	static bool Write(const std::string& path, std::uint32_t version, const void* data, std::size_t size);
+
+	// Maps the table at path. If there is no valid file, build fills a zeroed buffer of size bytes which is written
+	// to path and mapped afterwards, checksum included. If the file cannot be written the table stays in memory.
+	static std::shared_ptr<TableFile> LoadOrBuild(const std::string& path, std::uint32_t version, std::size_t size,
+		const std::function<void(std::uint8_t*)>& build);
+
+private:
+	void Unmap();
+
+	const std::uint8_t* m_data = nullptr;
+	std::size_t m_size = 0;
+	std::vector<std::uint8_t> m_buffer; // used instead of a mapping when the table could not be written
+
+	const std::uint8_t* m_view = nullptr; // start of the mapped file including the header
+	std::size_t m_viewSize = 0;
+#ifdef _WIN32
+	void* m_file = nullptr;
+	void* m_mapping = nullptr;
+#else
+	int m_file = -1;
+#endif
+};
@@ -0,0 +1,106 @@
+#include "ThreadPool.h"
+#include <algorithm>
+
+namespace
+{
+	thread_local const ThreadPool* t_pool = nullptr; // pool the current thread works for
+	thread_local int t_queueIndex = -1;
+}
+
+ThreadPool::ThreadPool(int threadCount)
+{
+	if (threadCount <= 0)
+		threadCount = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+	for (int i = 0; i <= threadCount; ++i) // the last one for tasks from outside the pool
+		m_queues.push_back(std::make_unique<Queue>());
+	for (int i = 0; i < threadCount; ++i)
+		m_threads.emplace_back(&ThreadPool::WorkerLoop, this, i);
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stopping = true;
+	}
+	m_workAvailable.notify_all();
+	for (std::thread& thread : m_threads)
+		thread.join();
+}
+
+void ThreadPool::Submit(std::function<void()> task)
+{
+	int index = t_pool == this ? t_queueIndex : GetOutsideQueue();
+	++m_pending;
+	{
+		std::lock_guard<std::mutex> lock(m_queues[index]->mutex);
+		m_queues[index]->tasks.push_back(std::move(task));
+	}
+	++m_queued;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex); // a worker that just found no work is waiting or sees m_queued
+	}
+	m_workAvailable.notify_one();
+	m_stateChanged.notify_all();
+}
+
+void ThreadPool::Wait(bool helping)
+{
+	int index = t_pool == this ? t_queueIndex : GetOutsideQueue();
+	while (m_pending > 0)
+	{
+		if (helping && RunTask(index))
+			continue;
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_stateChanged.wait(lock, [this, helping]() { return m_pending == 0 || (helping && m_queued > 0); });
+	}
+}
+
+bool ThreadPool::RunTask(int queueIndex)
+{
+	std::function<void()> task;
+	int queueCount = static_cast<int>(m_queues.size());
+	for (int i = 0; i < queueCount && !task; ++i)
+	{
+		Queue& queue = *m_queues[(queueIndex + i) % queueCount];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (queue.tasks.empty())
+			continue;
+		if (i == 0 && queueIndex != GetOutsideQueue()) // newest own task, its data is most likely still in the cache
+		{
+			task = std::move(queue.tasks.back());
+			queue.tasks.pop_back();
+		}
+		else
+		{
+			task = std::move(queue.tasks.front());
+			queue.tasks.pop_front();
+		}
+	}
+	if (!task)
+		return false;
+
+	--m_queued;
+	task();
+	if (--m_pending == 0)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stateChanged.notify_all();
+	}
+	return true;
+}
+
+void ThreadPool::WorkerLoop(int index)
+{
+	t_pool = this;
+	t_queueIndex = index;
+	while (true)
+	{
+		if (RunTask(index))
+			continue;
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_workAvailable.wait(lock, [this]() { return m_stopping || m_queued > 0; });
+		if (m_stopping && m_queued == 0)
+			return;
+	}
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads with one task queue each. A worker runs the newest task of its own queue and steals
+// the oldest task of another queue once its own runs empty; tasks submitted by a worker go to its own queue.
+// Tasks submitted from outside the pool go to one more queue that is only ever run oldest first, so they start in
+// the order they were submitted.
+class ThreadPool
+{
+public:
+	explicit ThreadPool(int threadCount = 0); // 0 means one thread per core
+	~ThreadPool(); // runs the remaining tasks before the threads end
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	int GetThreadCount() const { return static_cast<int>(m_threads.size()); }
+
+	void Submit(std::function<void()> task);
+	// blocks until all submitted tasks have finished; the calling thread helps running them unless helping is false,
+	// e.g. when exactly GetThreadCount tasks shall run at once
+	void Wait(bool helping = true);
+
+private:
+	struct Queue
+	{
+		std::mutex mutex;
+		std::deque<std::function<void()>> tasks;
+	};
+
+	bool RunTask(int queueIndex); // own queue first, then the others; false if all were empty
+	int GetOutsideQueue() const { return static_cast<int>(m_queues.size()) - 1; }
+	void WorkerLoop(int index);
+
+	std::vector<std::unique_ptr<Queue>> m_queues;
+	std::vector<std::thread> m_threads;
+	std::atomic<std::size_t> m_queued{ 0 };  // waiting in a queue
+	std::atomic<std::size_t> m_pending{ 0 }; // submitted and not finished yet
+	std::mutex m_mutex;
+	std::condition_variable m_workAvailable;
+	std::condition_variable m_stateChanged; // new tasks or nothing pending anymore, for Wait
+	bool m_stopping = false;
+};
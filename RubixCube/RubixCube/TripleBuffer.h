@@ -0,0 +1,39 @@
+#pragma once
+#include <atomic>
+
+// Hands the newest value of one writer thread to one reader thread without locks. Each side owns one of three slots;
+// the writer fills its slot and swaps it with the shared middle slot, the reader swaps its slot with the middle one
+// whenever a newer value waits there. Neither side ever waits for the other, values the reader is too slow for are
+// skipped. A slot the writer gets back holds an older value, not necessarily the one it wrote last.
+template <typename T>
+class TripleBuffer
+{
+public:
+	T& GetWriteSlot() { return m_slots[m_writeIndex]; }
+
+	void Publish() // the write slot becomes the newest value
+	{
+		int previous = m_middle.exchange(m_writeIndex | NEW_VALUE, std::memory_order_acq_rel);
+		m_writeIndex = previous & INDEX_MASK;
+	}
+
+	// the newest published value; it stays unchanged until the next call
+	const T& Read()
+	{
+		if (m_middle.load(std::memory_order_relaxed) & NEW_VALUE)
+		{
+			int previous = m_middle.exchange(m_readIndex, std::memory_order_acq_rel);
+			m_readIndex = previous & INDEX_MASK;
+		}
+		return m_slots[m_readIndex];
+	}
+
+private:
+	static const int INDEX_MASK = 3;
+	static const int NEW_VALUE = 4; // set in m_middle while the reader has not taken the value
+
+	T m_slots[3] = {};
+	int m_writeIndex = 0;           // writer thread only
+	std::atomic<int> m_middle{ 1 };
+	int m_readIndex = 2;            // reader thread only
+};
@@ -0,0 +1,295 @@
+#include "TwoPhaseSolver.h"
+#include "CubeCoordinates.h"
+#include "PruningTable.h"
+#include "PruningTableGenerator.h"
+#include "SolverTables.h"
+#include "TableFile.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace
+{
+	const int FACE_TURN_COUNT = 18; // U..B' come first in Move
+	const int PHASE2_MOVE_COUNT = 10;
+	const Move PHASE2_MOVES[PHASE2_MOVE_COUNT] = {
+		MOVE_U, MOVE_U2, MOVE_U_PRIME, MOVE_D, MOVE_D2, MOVE_D_PRIME, MOVE_R2, MOVE_F2, MOVE_L2, MOVE_B2 };
+	const int MAX_SEARCH_DEPTH = 32;
+	const std::uint32_t TABLE_VERSION = 1; // increase whenever a coordinate or table layout changes
+}
+
+struct TwoPhaseTables
+{
+	// phase 1 coordinates, [coordinate * FACE_TURN_COUNT + move]
+	const std::uint16_t* twistMove;
+	const std::uint16_t* flipMove;
+	const std::uint16_t* sliceMove;
+	// phase 2 coordinates, [coordinate * PHASE2_MOVE_COUNT + index into PHASE2_MOVES]
+	const std::uint16_t* cornerPermMove;
+	const std::uint16_t* edge8PermMove;
+	const std::uint16_t* slicePermMove;
+
+	PruningTable twistSlicePruning;      // [twist * SLICE_COUNT + slice]
+	PruningTable flipSlicePruning;       // [flip * SLICE_COUNT + slice]
+	PruningTable cornerSlicePermPruning; // [cornerPerm * SLICE_PERM_COUNT + slicePerm]
+	PruningTable edgeSlicePermPruning;   // [edge8Perm * SLICE_PERM_COUNT + slicePerm]
+
+	std::vector<std::shared_ptr<TableFile>> files; // keeps the mapped tables alive
+};
+
+namespace
+{
+	const std::uint16_t* LoadMoveTable(TwoPhaseTables& tables, const std::string& path,
+		int count, SolverTables::GetCoordinate get, SolverTables::SetCoordinate set, const Move* moves, int moveCount)
+	{
+		auto file = SolverTables::LoadMoveTable<std::uint16_t>(path, TABLE_VERSION, count, get, set, moves, moveCount);
+		tables.files.push_back(file);
+		return reinterpret_cast<const std::uint16_t*>(file->GetData());
+	}
+
+	PruningTable LoadPruningTable(TwoPhaseTables& tables, const std::string& path,
+		const std::uint16_t* moveA, int countA, const std::uint16_t* moveB, int countB, int moveCount)
+	{
+		std::size_t entries = static_cast<std::size_t>(countA) * countB;
+		auto file = SolverTables::LoadPruningTable(path, TABLE_VERSION, entries, [&](PruningTable table)
+			{
+				PruningTableGenerator::Generate(table, moveA, moveB, countB, moveCount, 0, SolverTables::PrintProgress);
+			});
+		tables.files.push_back(file);
+		return PruningTable(file->GetData(), entries);
+	}
+
+	TwoPhaseTables LoadTables(const std::string& directory)
+	{
+		Move faceTurns[FACE_TURN_COUNT];
+		for (int move = 0; move < FACE_TURN_COUNT; ++move)
+			faceTurns[move] = static_cast<Move>(move);
+
+		TwoPhaseTables tables;
+		tables.twistMove = LoadMoveTable(tables, directory + "/TwoPhaseTwistMove.tbl",
+			CubeCoordinates::TWIST_COUNT, CubeCoordinates::GetTwist, CubeCoordinates::SetTwist, faceTurns, FACE_TURN_COUNT);
+		tables.flipMove = LoadMoveTable(tables, directory + "/TwoPhaseFlipMove.tbl",
+			CubeCoordinates::FLIP_COUNT, CubeCoordinates::GetFlip, CubeCoordinates::SetFlip, faceTurns, FACE_TURN_COUNT);
+		tables.sliceMove = LoadMoveTable(tables, directory + "/TwoPhaseSliceMove.tbl",
+			CubeCoordinates::SLICE_COUNT, CubeCoordinates::GetSlice, CubeCoordinates::SetSlice, faceTurns, FACE_TURN_COUNT);
+		tables.cornerPermMove = LoadMoveTable(tables, directory + "/TwoPhaseCornerPermMove.tbl",
+			CubeCoordinates::CORNER_PERM_COUNT, CubeCoordinates::GetCornerPerm, CubeCoordinates::SetCornerPerm, PHASE2_MOVES, PHASE2_MOVE_COUNT);
+		tables.edge8PermMove = LoadMoveTable(tables, directory + "/TwoPhaseEdge8PermMove.tbl",
+			CubeCoordinates::EDGE8_PERM_COUNT, CubeCoordinates::GetEdge8Perm, CubeCoordinates::SetEdge8Perm, PHASE2_MOVES, PHASE2_MOVE_COUNT);
+		tables.slicePermMove = LoadMoveTable(tables, directory + "/TwoPhaseSlicePermMove.tbl",
+			CubeCoordinates::SLICE_PERM_COUNT, CubeCoordinates::GetSlicePerm, CubeCoordinates::SetSlicePerm, PHASE2_MOVES, PHASE2_MOVE_COUNT);
+
+		tables.twistSlicePruning = LoadPruningTable(tables, directory + "/TwoPhaseTwistSlicePruning.tbl",
+			tables.twistMove, CubeCoordinates::TWIST_COUNT, tables.sliceMove, CubeCoordinates::SLICE_COUNT, FACE_TURN_COUNT);
+		tables.flipSlicePruning = LoadPruningTable(tables, directory + "/TwoPhaseFlipSlicePruning.tbl",
+			tables.flipMove, CubeCoordinates::FLIP_COUNT, tables.sliceMove, CubeCoordinates::SLICE_COUNT, FACE_TURN_COUNT);
+		tables.cornerSlicePermPruning = LoadPruningTable(tables, directory + "/TwoPhaseCornerSlicePermPruning.tbl",
+			tables.cornerPermMove, CubeCoordinates::CORNER_PERM_COUNT, tables.slicePermMove, CubeCoordinates::SLICE_PERM_COUNT, PHASE2_MOVE_COUNT);
+		tables.edgeSlicePermPruning = LoadPruningTable(tables, directory + "/TwoPhaseEdgeSlicePermPruning.tbl",
+			tables.edge8PermMove, CubeCoordinates::EDGE8_PERM_COUNT, tables.slicePermMove, CubeCoordinates::SLICE_PERM_COUNT, PHASE2_MOVE_COUNT);
+		return tables;
+	}
+
+	const TwoPhaseTables& GetTables(const std::string& directory)
+	{
+		// one set per directory, loaded by the first solver that uses it
+		static std::mutex mutex;
+		static std::map<std::string, std::unique_ptr<TwoPhaseTables>> tables;
+		std::lock_guard<std::mutex> lock(mutex);
+		std::unique_ptr<TwoPhaseTables>& loaded = tables[directory];
+		if (!loaded)
+			loaded = std::make_unique<TwoPhaseTables>(LoadTables(directory));
+		return *loaded;
+	}
+
+	bool IsPhase2Move(Move move)
+	{
+		int face = move / 3;
+		return face == 0 || face == 3 || move % 3 == 1; // U, D or a half turn
+	}
+
+	class Search
+	{
+	public:
+		Search(const TwoPhaseTables& tables, const CubeState& cube, int maxLength, double timeLimit, unsigned nodeLimit)
+			: m_tables(tables), m_cube(cube), m_best(std::min(maxLength, MAX_SEARCH_DEPTH) + 1)
+			, m_deadline(std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(timeLimit)))
+			, m_nodeLimit(nodeLimit) {}
+
+		// every solution found is shorter than the one before; the search goes on with longer phase 1 solutions
+		// until phase 1 alone is as long as the best one, or the time or node budget is up once there is a solution
+		bool Run(std::vector<Move>& solution)
+		{
+			int twist = CubeCoordinates::GetTwist(m_cube);
+			int flip = CubeCoordinates::GetFlip(m_cube);
+			int slice = CubeCoordinates::GetSlice(m_cube);
+			for (int depth = Phase1Distance(twist, flip, slice); depth < m_best && !m_stopped; ++depth)
+				Phase1(twist, flip, slice, 0, depth);
+			if (!m_found)
+				return false;
+			solution.insert(solution.end(), m_bestPath, m_bestPath + m_best);
+			return true;
+		}
+
+	private:
+		int Phase1Distance(int twist, int flip, int slice) const
+		{
+			return std::max(m_tables.twistSlicePruning.Get(twist * CubeCoordinates::SLICE_COUNT + slice),
+				m_tables.flipSlicePruning.Get(flip * CubeCoordinates::SLICE_COUNT + slice));
+		}
+
+		int Phase2Distance(int cornerPerm, int edge8Perm, int slicePerm) const
+		{
+			return std::max(m_tables.cornerSlicePermPruning.Get(cornerPerm * CubeCoordinates::SLICE_PERM_COUNT + slicePerm),
+				m_tables.edgeSlicePermPruning.Get(edge8Perm * CubeCoordinates::SLICE_PERM_COUNT + slicePerm));
+		}
+
+		// turning the same face twice in a row, or opposite faces in both orders, never shortens a solution
+		bool IsRedundant(Move move, int depth) const
+		{
+			if (depth == 0)
+				return false;
+			int face = move / 3;
+			int lastFace = m_path[depth - 1] / 3;
+			return face == lastFace || face == lastFace - 3;
+		}
+
+		// only once there is a solution to return; the clock is read every few thousand nodes and after each phase 2,
+		// with a node limit it is not read at all and each phase 2 counts as one more node
+		bool IsTimeUp(bool everyNode)
+		{
+			if (m_stopped || !m_found)
+				return m_stopped;
+			if (m_nodeLimit != 0)
+				m_stopped = ++m_nodeCount >= m_nodeLimit;
+			else if (everyNode || (++m_nodeCount & 4095) == 0)
+				m_stopped = std::chrono::steady_clock::now() >= m_deadline;
+			return m_stopped;
+		}
+
+		// returns true when the search has to stop
+		bool Phase1(int twist, int flip, int slice, int depth, int togo)
+		{
+			if (IsTimeUp(false))
+				return true;
+			if (togo == 0)
+			{
+				// a phase 1 solution ending in a phase 2 move was already tried one depth earlier
+				if (twist != 0 || flip != 0 || slice != 0 || (depth > 0 && IsPhase2Move(m_path[depth - 1])))
+					return false;
+				StartPhase2(depth);
+				return IsTimeUp(true);
+			}
+
+			for (int i = 0; i < FACE_TURN_COUNT; ++i)
+			{
+				Move move = static_cast<Move>(i);
+				if (IsRedundant(move, depth))
+					continue;
+				int nextTwist = m_tables.twistMove[twist * FACE_TURN_COUNT + i];
+				int nextFlip = m_tables.flipMove[flip * FACE_TURN_COUNT + i];
+				int nextSlice = m_tables.sliceMove[slice * FACE_TURN_COUNT + i];
+				if (Phase1Distance(nextTwist, nextFlip, nextSlice) > togo - 1)
+					continue;
+				m_path[depth] = move;
+				if (Phase1(nextTwist, nextFlip, nextSlice, depth + 1, togo - 1))
+					return true;
+			}
+			return false;
+		}
+
+		void StartPhase2(int phase1Length)
+		{
+			// the phase 2 coordinates are not tracked through phase 1, replay the moves on the cube instead
+			CubeState cube = m_cube;
+			for (int i = 0; i < phase1Length; ++i)
+				cube.ApplyMove(m_path[i]);
+
+			int cornerPerm = CubeCoordinates::GetCornerPerm(cube);
+			int edge8Perm = CubeCoordinates::GetEdge8Perm(cube);
+			int slicePerm = CubeCoordinates::GetSlicePerm(cube);
+			for (int depth = Phase2Distance(cornerPerm, edge8Perm, slicePerm); phase1Length + depth < m_best && !m_stopped; ++depth)
+			{
+				if (Phase2(cornerPerm, edge8Perm, slicePerm, phase1Length, depth))
+				{
+					m_best = phase1Length + depth;
+					std::copy(m_path, m_path + m_best, m_bestPath);
+					m_found = true;
+					break;
+				}
+			}
+		}
+
+		bool Phase2(int cornerPerm, int edge8Perm, int slicePerm, int depth, int togo)
+		{
+			if (togo == 0)
+				return cornerPerm == 0 && edge8Perm == 0 && slicePerm == 0;
+			if (IsTimeUp(false))
+				return false;
+
+			for (int i = 0; i < PHASE2_MOVE_COUNT; ++i)
+			{
+				Move move = PHASE2_MOVES[i];
+				if (IsRedundant(move, depth))
+					continue;
+				int nextCornerPerm = m_tables.cornerPermMove[cornerPerm * PHASE2_MOVE_COUNT + i];
+				int nextEdge8Perm = m_tables.edge8PermMove[edge8Perm * PHASE2_MOVE_COUNT + i];
+				int nextSlicePerm = m_tables.slicePermMove[slicePerm * PHASE2_MOVE_COUNT + i];
+				if (Phase2Distance(nextCornerPerm, nextEdge8Perm, nextSlicePerm) > togo - 1)
+					continue;
+				m_path[depth] = move;
+				if (Phase2(nextCornerPerm, nextEdge8Perm, nextSlicePerm, depth + 1, togo - 1))
+					return true;
+			}
+			return false;
+		}
+
+		const TwoPhaseTables& m_tables;
+		const CubeState& m_cube;
+		int m_best;                          // length of the best solution so far, one more than allowed before the first
+		std::chrono::steady_clock::time_point m_deadline;
+		unsigned m_nodeLimit;                // nodes after the first solution, 0 to use m_deadline instead
+		bool m_found = false;
+		bool m_stopped = false;
+		unsigned m_nodeCount = 0;
+		Move m_path[MAX_SEARCH_DEPTH];
+		Move m_bestPath[MAX_SEARCH_DEPTH];
+	};
+}
+
+TwoPhaseSolver::TwoPhaseSolver(const std::string& tableDirectory)
+	: m_tables(&GetTables(tableDirectory))
+{
+}
+
+bool TwoPhaseSolver::Solve(const CubeState& cube, std::vector<Move>& solution, int maxLength, double timeLimit,
+	unsigned nodeLimit) const
+{
+	solution.clear();
+	Move fix[2];
+	int fixLength = cube.FindCenterFix(fix);
+	if (fixLength < 0)
+		return false;
+	solution.assign(fix, fix + fixLength);
+
+	CubeState centered = cube;
+	for (Move move : solution)
+		centered.ApplyMove(move);
+	if (!CubeCoordinates::IsSolvable(centered))
+	{
+		solution.clear();
+		return false;
+	}
+
+	Search search(*m_tables, centered, maxLength, timeLimit, nodeLimit);
+	if (!search.Run(solution))
+	{
+		solution.clear();
+		return false;
+	}
+	return true;
+}
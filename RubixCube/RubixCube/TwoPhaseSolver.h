@@ -0,0 +1,33 @@
+#pragma once
+#include "CubeState.h"
+#include "SolverTables.h"
+#include <string>
+#include <vector>
+
+struct TwoPhaseTables;
+
+// Kociemba's two-phase algorithm: phase 1 brings the cube into the subgroup <U, D, R2, L2, F2, B2>,
+// phase 2 solves it inside that subgroup. The move and pruning tables are shared by all solvers with the same
+// tableDirectory. The first of them maps the tables from there, or builds and stores them if they are missing or outdated.
+// The solver itself does not touch OpenGL.
+class TwoPhaseSolver
+{
+public:
+	static const int DEFAULT_MAX_LENGTH = 22;
+	static constexpr double DEFAULT_TIME_LIMIT = 0.005; // seconds, see Solve
+	static const unsigned DEFAULT_NODE_LIMIT = 5000; // gives solutions about as short as DEFAULT_TIME_LIMIT
+
+	explicit TwoPhaseSolver(const std::string& tableDirectory = SolverTables::DEFAULT_DIRECTORY);
+
+	// Finds at most maxLength face turns that solve the cube. If middle layer turns moved the centers,
+	// up to two slice turns that bring them back are put in front. Returns false if the cube is not solvable.
+	// After the first solution the search goes on for shorter ones until timeLimit seconds have passed since the
+	// start. If it runs out of phase 1 solutions shorter than the best one before that, the result is optimal.
+	// A nodeLimit other than 0 replaces the time limit: the search ends after that many nodes past the first
+	// solution, so the result no longer depends on the speed of the machine, e.g. when replaying an input log.
+	bool Solve(const CubeState& cube, std::vector<Move>& solution, int maxLength = DEFAULT_MAX_LENGTH,
+		double timeLimit = DEFAULT_TIME_LIMIT, unsigned nodeLimit = 0) const;
+
+private:
+	const TwoPhaseTables* m_tables; // shared with all solvers of the same table directory
+};
@@ -1,6 +1,10 @@
 #version 330
 
-uniform mat4 transformation;
+layout(std140) uniform Camera
+{
+	mat4 viewProjection;
+};
+uniform mat4 model; // placement of the cubie in the world
 
 layout(location = 0) in vec3 position;
 layout(location = 1) in vec3 inColor;
@@ -9,6 +13,6 @@ out vec3 vertColor;
 
 void main()
 {
-	gl_Position = transformation * vec4(position, 1.0);
+	gl_Position = viewProjection * model * vec4(position, 1.0);
 	vertColor = inColor;
 }
\ No newline at end of file
@@ -0,0 +1,19 @@
+#version 330
+
+layout(std140) uniform Camera
+{
+	mat4 viewProjection;
+};
+uniform mat4 model; // orientation of the whole cube
+
+layout(location = 0) in vec3 position;
+layout(location = 1) in vec3 inColor;
+layout(location = 2) in mat4 cubieTransformation; // per instance, occupies the locations 2 to 5
+
+out vec3 vertColor;
+
+void main()
+{
+	gl_Position = viewProjection * (model * (cubieTransformation * vec4(position, 1.0)));
+	vertColor = inColor;
+}
\ No newline at end of file
@@ -0,0 +1,21 @@
+#version 330
+
+layout(std140) uniform Camera
+{
+	mat4 viewProjection; // the cubes themselves are not rotated
+};
+
+layout(location = 0) in vec3 position;
+layout(location = 1) in vec3 inColor;
+layout(location = 2) in vec3 cubieCenter; // per instance, in world space
+layout(location = 3) in vec3 rotationX;   // per instance: the columns of the cubie rotation
+layout(location = 4) in vec3 rotationY;
+layout(location = 5) in vec3 rotationZ;
+
+out vec3 vertColor;
+
+void main()
+{
+	gl_Position = viewProjection * vec4(cubieCenter + mat3(rotationX, rotationY, rotationZ) * position, 1.0);
+	vertColor = inColor;
+}
\ No newline at end of file
@@ -0,0 +1,23 @@
+#version 330
+
+layout(std140) uniform Camera
+{
+	mat4 viewProjection; // the cubes themselves are not rotated
+};
+uniform vec3 faceColors[6];         // in face order U R F D L B
+uniform usamplerBuffer faceletFaces; // per cube the face whose color each of the 54 facelets shows
+
+layout(location = 0) in vec3 position;
+layout(location = 1) in int facelet;       // face * 9 + index on the face, -1 for the black body
+layout(location = 2) in vec3 cubePosition; // per instance
+
+out vec3 vertColor;
+
+void main()
+{
+	gl_Position = viewProjection * vec4(cubePosition + position, 1.0);
+	if (facelet < 0)
+		vertColor = vec3(0.05);
+	else
+		vertColor = faceColors[texelFetch(faceletFaces, gl_InstanceID * 54 + facelet).r];
+}
\ No newline at end of file
@@ -0,0 +1,199 @@
+#include "CubeState.h"
+#include "MoveNotation.h"
+#include "OptimalSolver.h"
+#include "ThreadPool.h"
+#include "TwoPhaseSolver.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Headless batch solver: reads one scramble in Singmaster notation per line from a file or stdin and writes
+// "line <tab> solution <tab> length <tab> microseconds" per scramble, in input order. Nothing here opens a window.
+//
+// Usage: RubixCubeBatch [--input file] [--output file] [--threads n] [--max-length n] [--optimal] [--tables directory]
+
+struct BatchOptions
+{
+    std::string inputPath;  // stdin if empty
+    std::string outputPath; // stdout if empty
+    std::string tableDirectory = SolverTables::DEFAULT_DIRECTORY;
+    int threadCount = 0;    // one per core
+    int maxLength = TwoPhaseSolver::DEFAULT_MAX_LENGTH;
+    bool optimal = false;
+};
+
+struct BatchResult
+{
+    enum Status { SOLVED, INVALID_MOVE, NO_SOLUTION } status = NO_SOLUTION;
+    std::vector<Move> solution; // kept between chunks so that its memory is reused
+    size_t errorPosition = 0;   // where the invalid move starts
+    long long microseconds = 0;
+};
+
+typedef std::function<bool(const CubeState&, std::vector<Move>&)> SolveFunction;
+
+const size_t CHUNK_SIZE = 4096;      // lines that are solved in parallel before their results are written
+const size_t MAX_OUTPUT_LENGTH = 256; // more than enough for any solution the solvers return
+
+/**
+* \brief Solves the scramble of one input line and measures how long that took.
+*/
+void SolveLine(const std::string& line, const SolveFunction& solve, BatchResult& result)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    CubeState cube;
+    MoveParser parser(line);
+    Move move;
+    while (parser.Next(move))
+        cube.ApplyMove(move);
+
+    result.solution.clear();
+    if (parser.HasError())
+    {
+        result.status = BatchResult::INVALID_MOVE;
+        result.errorPosition = parser.GetPosition();
+    }
+    else
+        result.status = solve(cube, result.solution) ? BatchResult::SOLVED : BatchResult::NO_SOLUTION;
+
+    result.microseconds = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+* \brief Reads the command line; prints the usage and returns false on unknown arguments.
+*/
+bool ParseArguments(int argc, char** argv, BatchOptions& options)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--input") == 0 && hasValue)
+            options.inputPath = argv[++i];
+        else if (std::strcmp(argv[i], "--output") == 0 && hasValue)
+            options.outputPath = argv[++i];
+        else if (std::strcmp(argv[i], "--tables") == 0 && hasValue)
+            options.tableDirectory = argv[++i];
+        else if (std::strcmp(argv[i], "--threads") == 0 && hasValue)
+            options.threadCount = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--max-length") == 0 && hasValue)
+            options.maxLength = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--optimal") == 0)
+            options.optimal = true;
+        else
+        {
+            std::cerr << "Usage: RubixCubeBatch [--input file] [--output file] [--threads n] [--max-length n] "
+                "[--optimal] [--tables directory]" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    BatchOptions options;
+    if (!ParseArguments(argc, argv, options))
+        return 1;
+
+    std::ifstream inputFile;
+    if (!options.inputPath.empty())
+    {
+        inputFile.open(options.inputPath);
+        if (!inputFile)
+        {
+            std::cerr << "Could not open " << options.inputPath << std::endl;
+            return 1;
+        }
+    }
+    std::ofstream outputFile;
+    if (!options.outputPath.empty())
+    {
+        outputFile.open(options.outputPath);
+        if (!outputFile)
+        {
+            std::cerr << "Could not open " << options.outputPath << std::endl;
+            return 1;
+        }
+    }
+    std::istream& input = options.inputPath.empty() ? std::cin : inputFile;
+    std::ostream& output = options.outputPath.empty() ? std::cout : outputFile;
+
+    // the scrambles are spread over the pool, so every single search runs on one thread
+    std::unique_ptr<TwoPhaseSolver> twoPhaseSolver;
+    std::unique_ptr<OptimalSolver> optimalSolver;
+    SolveFunction solve;
+    if (options.optimal)
+    {
+        optimalSolver = std::make_unique<OptimalSolver>(options.tableDirectory, 1);
+        int maxLength = std::min(options.maxLength, static_cast<int>(OptimalSolver::MAX_LENGTH));
+        solve = [&, maxLength](const CubeState& cube, std::vector<Move>& solution) { return optimalSolver->Solve(cube, solution, maxLength); };
+    }
+    else
+    {
+        twoPhaseSolver = std::make_unique<TwoPhaseSolver>(options.tableDirectory);
+        solve = [&](const CubeState& cube, std::vector<Move>& solution) { return twoPhaseSolver->Solve(cube, solution, options.maxLength); };
+    }
+
+    ThreadPool pool(options.threadCount);
+    std::vector<std::string> lines;
+    std::vector<BatchResult> results;
+    size_t lineNumber = 0, solvedCount = 0, totalLength = 0;
+    auto start = std::chrono::steady_clock::now();
+
+    // lines and results are reused chunk after chunk, so after the first chunk nothing is allocated per line
+    size_t lineCount = 0;
+    char text[MAX_OUTPUT_LENGTH];
+    while (input)
+    {
+        lineCount = 0;
+        while (lineCount < CHUNK_SIZE)
+        {
+            if (lineCount == lines.size())
+                lines.emplace_back();
+            if (!std::getline(input, lines[lineCount]))
+                break;
+            ++lineCount;
+        }
+        if (lineCount == 0)
+            break;
+
+        if (results.size() < lineCount)
+            results.resize(lineCount);
+        for (size_t i = 0; i < lineCount; ++i)
+            pool.Submit([&, i]() { SolveLine(lines[i], solve, results[i]); });
+        pool.Wait(false); // the main thread only waits: --threads searches at once, and their times are not disturbed
+
+        for (size_t i = 0; i < lineCount; ++i)
+        {
+            const BatchResult& result = results[i];
+            ++lineNumber;
+            if (result.status == BatchResult::SOLVED)
+            {
+                ++solvedCount;
+                totalLength += result.solution.size();
+                MoveNotation::Format(result.solution.data(), result.solution.size(), text, MAX_OUTPUT_LENGTH);
+                output << lineNumber << '\t' << text << '\t' << result.solution.size() << '\t' << result.microseconds << '\n';
+            }
+            else if (result.status == BatchResult::INVALID_MOVE)
+                output << lineNumber << "\tERROR: invalid move at column " << result.errorPosition + 1 << "\t-\t" << result.microseconds << '\n';
+            else
+                output << lineNumber << "\tERROR: no solution found\t-\t" << result.microseconds << '\n';
+        }
+        output.flush();
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cerr << "Solved " << solvedCount << " of " << lineNumber << " scrambles in " << seconds << " s";
+    if (solvedCount > 0)
+        std::cerr << ", " << static_cast<double>(totalLength) / solvedCount << " moves on average";
+    std::cerr << std::endl;
+    return solvedCount == lineNumber ? 0 : 2;
+}
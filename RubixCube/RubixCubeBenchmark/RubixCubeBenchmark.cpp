@@ -0,0 +1,368 @@
+#define GLEW_STATIC
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+#include "CameraUniforms.h"
+#include "CubeLogic.h"
+#include "CubeSceneRenderer.h"
+#include "CubeState.h"
+#include "CubieRenderer.h"
+#include "InputSystem.h"
+#include "ShaderUtil.h"
+#include <glm/ext.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+// Micro benchmarks of the hot paths of the game: turning layers, the integer cube model, one frame of rendering,
+// building the shader program and polling the keyboard. Every benchmark reports nanoseconds and heap allocations
+// per operation; the results are written as JSON so that runs of different commits can be compared.
+// The OpenGL benchmarks render into a hidden window.
+//
+// Usage: RubixCubeBenchmark [--output file] [--min-time seconds] [--filter text] [--data directory]
+
+struct BenchmarkOptions
+{
+    std::string outputPath;               // stdout if empty
+    std::string filter;                   // only benchmarks whose name contains this text
+    std::string dataDirectory = "../RubixCube"; // where the shaders are, relative to the working directory
+    double minSeconds = 0.5;              // every benchmark runs at least this long
+};
+
+struct BenchmarkResult
+{
+    std::string name;
+    size_t iterations = 0;
+    double nanosecondsPerOp = 0.0;
+    double allocationsPerOp = 0.0;
+};
+
+// runs the operation under test the given number of times
+typedef std::function<void(size_t iterations)> BenchmarkBody;
+
+std::atomic<size_t> g_allocationCount(0); // heap allocations since the start of the program
+
+// all other forms of new (arrays, nothrow) end up here
+void* operator new(size_t size)
+{
+    g_allocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (void* memory = std::malloc(size > 0 ? size : 1))
+        return memory;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept
+{
+    std::free(memory);
+}
+
+/**
+* \brief Doubles the number of iterations until one run takes at least minSeconds and measures that run.
+*/
+BenchmarkResult RunBenchmark(const char* name, double minSeconds, const BenchmarkBody& body)
+{
+    body(1); // warm up caches, lazily built tables and the driver
+
+    BenchmarkResult result;
+    result.name = name;
+    for (size_t iterations = 1;; iterations *= 2)
+    {
+        size_t allocations = g_allocationCount.load(std::memory_order_relaxed);
+        auto start = std::chrono::steady_clock::now();
+        body(iterations);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        allocations = g_allocationCount.load(std::memory_order_relaxed) - allocations;
+
+        if (seconds >= minSeconds || iterations >= (size_t(1) << 40))
+        {
+            result.iterations = iterations;
+            result.nanosecondsPerOp = seconds * 1e9 / iterations;
+            result.allocationsPerOp = static_cast<double>(allocations) / iterations;
+            return result;
+        }
+    }
+}
+
+/**
+* \brief Writes text as a JSON string literal.
+*/
+void WriteJsonString(std::ostream& output, const char* text)
+{
+    output << '"';
+    for (; *text != '\0'; ++text)
+    {
+        if (*text == '"' || *text == '\\')
+            output << '\\' << *text;
+        else if (static_cast<unsigned char>(*text) >= 0x20)
+            output << *text;
+    }
+    output << '"';
+}
+
+/**
+* \brief Reads the command line; prints the usage and returns false on unknown arguments.
+*/
+bool ParseArguments(int argc, char** argv, BenchmarkOptions& options)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--output") == 0 && hasValue)
+            options.outputPath = argv[++i];
+        else if (std::strcmp(argv[i], "--filter") == 0 && hasValue)
+            options.filter = argv[++i];
+        else if (std::strcmp(argv[i], "--data") == 0 && hasValue)
+            options.dataDirectory = argv[++i];
+        else if (std::strcmp(argv[i], "--min-time") == 0 && hasValue)
+            options.minSeconds = std::atof(argv[++i]);
+        else
+        {
+            std::cerr << "Usage: RubixCubeBenchmark [--output file] [--min-time seconds] [--filter text] [--data directory]" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+* \brief Opens an invisible window with the same OpenGL context the game uses.
+*/
+GLFWwindow* CreateHiddenWindow()
+{
+    if (!glfwInit())
+        return nullptr;
+
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+    GLFWwindow* window = glfwCreateWindow(1024, 768, "Rubix Cube Benchmark", nullptr, nullptr);
+    if (window == nullptr)
+        return nullptr;
+    glfwMakeContextCurrent(window);
+    glfwSwapInterval(0);
+
+    glewExperimental = true;
+    if (glewInit() != GLEW_OK)
+        return nullptr;
+    return window;
+}
+
+int main(int argc, char** argv)
+{
+    BenchmarkOptions options;
+    if (!ParseArguments(argc, argv, options))
+        return 1;
+
+    std::error_code error;
+    std::filesystem::current_path(options.dataDirectory, error);
+    if (error)
+    {
+        std::cerr << "Could not change into " << options.dataDirectory << ": " << error.message() << std::endl;
+        return 1;
+    }
+
+    GLFWwindow* window = CreateHiddenWindow();
+    if (window == nullptr)
+    {
+        std::cerr << "Could not create an OpenGL 3.3 context" << std::endl;
+        glfwTerminate();
+        return 1;
+    }
+
+    CubeLogic cubeLogic;
+    cubeLogic.Initialize(window);
+    cubeLogic.SetSoundEnabled(false);
+
+    InputSystem input; // observes the same keys as the game
+    input.SetWindow(window);
+    const int keys[] = { GLFW_KEY_SPACE, GLFW_KEY_R, GLFW_KEY_S, GLFW_KEY_RIGHT, GLFW_KEY_LEFT, GLFW_KEY_UP, GLFW_KEY_DOWN,
+        GLFW_KEY_KP_0, GLFW_KEY_KP_1, GLFW_KEY_KP_2, GLFW_KEY_KP_3, GLFW_KEY_KP_4, GLFW_KEY_KP_6, GLFW_KEY_KP_7,
+        GLFW_KEY_KP_8, GLFW_KEY_KP_9, GLFW_KEY_LEFT_SHIFT };
+    for (int key : keys)
+        input.ObserveKey(key);
+
+    CubieRenderer cubieRenderer;
+    cubieRenderer.Initialize();
+    CameraUniforms camera; // for the renderers that are used without CubeLogic
+    camera.Initialize();
+
+    // a wall of 100 x 100 scrambled cubes for the scene renderer
+    const int sceneCubeCount = 10000;
+    CubeSceneRenderer sceneRenderer, stickerRenderer;
+    sceneRenderer.Initialize(sceneCubeCount);
+    stickerRenderer.Initialize(sceneCubeCount, CubeSceneRenderer::STICKER_MODE);
+    std::vector<CubeState> sceneCubes(sceneCubeCount);
+    std::vector<glm::vec3> scenePositions(sceneCubeCount);
+    std::mt19937 random(1);
+    float spacing = 1.2f * sceneRenderer.GetCubeExtension();
+    for (int i = 0; i < sceneCubeCount; ++i)
+    {
+        for (int move = 0; move < 20; ++move)
+            sceneCubes[i].ApplyMove(static_cast<Move>(random() % MOVE_COUNT));
+        scenePositions[i] = glm::vec3((i % 100 - 49.5f) * spacing, (i / 100 - 49.5f) * spacing, 0.0f);
+    }
+
+    volatile int sink = 0; // keeps the compiler from dropping results nobody reads
+
+    std::vector<std::pair<const char*, BenchmarkBody>> benchmarks;
+    benchmarks.emplace_back("CubeLogic::RotateLayer", [&](size_t iterations)
+        {
+            for (size_t i = 0; i < iterations; ++i) // all 18 screen aligned layer turns one after another
+                cubeLogic.RotateLayer((i & 1) ? 'x' : 'y', (i & 2) ? 1 : -1, static_cast<int>(i / 4 % 3));
+        });
+    benchmarks.emplace_back("CubeLogic::FindLayerMove", [&](size_t iterations)
+        {
+            int moves = 0;
+            for (size_t i = 0; i < iterations; ++i)
+                moves += cubeLogic.FindLayerMove((i & 1) ? 'x' : 'y', (i & 2) ? 1 : -1, static_cast<int>(i / 4 % 3));
+            sink = moves;
+        });
+    benchmarks.emplace_back("CubeState::ApplyMove", [&](size_t iterations)
+        {
+            CubeState cube;
+            for (size_t i = 0; i < iterations; ++i)
+                cube.ApplyMove(static_cast<Move>(i % MOVE_COUNT));
+            sink = cube == CubeState();
+        });
+    benchmarks.emplace_back("CubeLogic::UpdateCubieTransforms", [&](size_t iterations)
+        {
+            for (size_t i = 0; i < iterations; ++i)
+                cubeLogic.UpdateCubieTransforms();
+        });
+    benchmarks.emplace_back("CubeLogic::Render", [&](size_t iterations)
+        {
+            // one frame of all 27 cubies, waiting for the GPU so that driver work is not left out
+            glViewport(0, 0, 1024, 768);
+            glEnable(GL_DEPTH_TEST);
+            glDepthFunc(GL_LEQUAL);
+            for (size_t i = 0; i < iterations; ++i)
+            {
+                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+                cubeLogic.Render(1024.0f / 768.0f);
+                glFinish();
+            }
+        });
+    benchmarks.emplace_back("CubieRenderer::Render x27", [&](size_t iterations)
+        {
+            // the frame drawn cubie by cubie with one draw call each, for comparison with the instanced CubeLogic::Render
+            for (size_t i = 0; i < iterations; ++i)
+            {
+                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+                camera.Update(glm::perspective(glm::radians(45.0f), 1024.0f / 768.0f, 0.1f, 100.0f)
+                    * glm::lookAt(glm::vec3(0.0f, 0.0f, 9.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f)));
+                for (int cubie = 0; cubie < 27; ++cubie)
+                {
+                    glm::vec3 offset((cubie % 3 - 1) * 1.05f, (cubie / 3 % 3 - 1) * 1.05f, (cubie / 9 - 1) * 1.05f);
+                    cubieRenderer.Render(glm::translate(glm::mat4(1.0f), offset));
+                }
+                glFinish();
+            }
+        });
+    benchmarks.emplace_back("CubeSceneRenderer::Render 10000 cubes", [&](size_t iterations)
+        {
+            glm::mat4 viewProjection = glm::perspective(glm::radians(45.0f), 1024.0f / 768.0f, 1.0f, 1000.0f)
+                * glm::lookAt(glm::vec3(0.0f, 0.0f, 120.0f * spacing), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+            for (size_t i = 0; i < iterations; ++i)
+            {
+                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+                camera.Update(viewProjection);
+                sceneRenderer.Render(sceneCubes.data(), scenePositions.data(), sceneCubeCount);
+                glFinish();
+            }
+        });
+    benchmarks.emplace_back("CubeSceneRenderer::Render 10000 cubes stickers", [&](size_t iterations)
+        {
+            glm::mat4 viewProjection = glm::perspective(glm::radians(45.0f), 1024.0f / 768.0f, 1.0f, 1000.0f)
+                * glm::lookAt(glm::vec3(0.0f, 0.0f, 120.0f * spacing), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+            for (size_t i = 0; i < iterations; ++i)
+            {
+                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+                camera.Update(viewProjection);
+                stickerRenderer.Render(sceneCubes.data(), scenePositions.data(), sceneCubeCount);
+                glFinish();
+            }
+        });
+    benchmarks.emplace_back("ShaderUtil::CreateShaderProgram cached", [&](size_t iterations)
+        {
+            // all but a first run load the binary the one before stored in the shader cache
+            for (size_t i = 0; i < iterations; ++i)
+                glDeleteProgram(ShaderUtil::CreateShaderProgram("VertexShaderColor.glsl", "FragmentShaderColor.glsl"));
+        });
+    benchmarks.emplace_back("ShaderUtil::StartShaderProgram cold", [&](size_t iterations)
+        {
+            // compiles from source every time, bypassing the shader cache (a driver may still keep one of its own)
+            for (size_t i = 0; i < iterations; ++i)
+            {
+                GLuint program = ShaderUtil::StartShaderProgram("VertexShaderColor.glsl", "FragmentShaderColor.glsl");
+                sink = ShaderUtil::FinishShaderProgram(program);
+                glDeleteProgram(program);
+            }
+        });
+    benchmarks.emplace_back("InputSystem::Update", [&](size_t iterations)
+        {
+            for (size_t i = 0; i < iterations; ++i)
+                input.Update();
+            sink = input.IsKeyDown(GLFW_KEY_SPACE);
+        });
+
+    std::vector<BenchmarkResult> results;
+    for (const auto& benchmark : benchmarks)
+    {
+        if (options.filter.empty() || std::strstr(benchmark.first, options.filter.c_str()) != nullptr)
+        {
+            results.push_back(RunBenchmark(benchmark.first, options.minSeconds, benchmark.second));
+            std::cerr << results.back().name << ": " << results.back().nanosecondsPerOp << " ns/op, "
+                << results.back().allocationsPerOp << " allocations/op" << std::endl;
+        }
+    }
+
+    std::ofstream outputFile;
+    if (!options.outputPath.empty())
+    {
+        outputFile.open(options.outputPath);
+        if (!outputFile)
+        {
+            std::cerr << "Could not open " << options.outputPath << std::endl;
+            return 1;
+        }
+    }
+    std::ostream& output = options.outputPath.empty() ? std::cout : outputFile;
+
+    output << "{\n  \"renderer\": ";
+    WriteJsonString(output, reinterpret_cast<const char*>(glGetString(GL_RENDERER)));
+    output << ",\n  \"version\": ";
+    WriteJsonString(output, reinterpret_cast<const char*>(glGetString(GL_VERSION)));
+    output << ",\n  \"benchmarks\": [";
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        output << (i > 0 ? "," : "") << "\n    { \"name\": ";
+        WriteJsonString(output, results[i].name.c_str());
+        output << ", \"iterations\": " << results[i].iterations << ", \"ns_per_op\": " << results[i].nanosecondsPerOp
+            << ", \"allocations_per_op\": " << results[i].allocationsPerOp << " }";
+    }
+    output << "\n  ]\n}" << std::endl;
+
+    camera.ClearResources();
+    stickerRenderer.ClearResources();
+    sceneRenderer.ClearResources();
+    cubieRenderer.ClearResources();
+    cubeLogic.ClearResources();
+    glfwDestroyWindow(window);
+    glfwTerminate();
+    return 0;
+}
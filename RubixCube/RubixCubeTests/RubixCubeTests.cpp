@@ -0,0 +1,98 @@
+#include "CubeState.h"
+#include "OptimalSolver.h"
+#include "SolverTables.h"
+#include "ThreadPool.h"
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Checks of the parts whose behavior is not visible in the results alone, e.g. how the parallel search is scheduled.
+// Prints one line per failed check and returns the number of failures. Nothing here opens a window.
+//
+// Usage: RubixCubeTests [--tables directory]
+
+int g_failedCount = 0;
+
+void Check(bool condition, const std::string& message)
+{
+    if (!condition)
+    {
+        std::cerr << "FAILED: " << message << std::endl;
+        ++g_failedCount;
+    }
+}
+
+/**
+* \brief Tasks submitted from outside the pool start in the order they were submitted.
+*/
+void TestThreadPoolOrder()
+{
+    const int taskCount = 100;
+    ThreadPool pool(1); // a single worker starts the tasks one after another
+    std::atomic<bool> submitted(false);
+    pool.Submit([&submitted]() { while (!submitted) std::this_thread::yield(); }); // all tasks are queued meanwhile
+    std::vector<int> order;
+    for (int task = 0; task < taskCount; ++task)
+        pool.Submit([&order, task]() { order.push_back(task); });
+    submitted = true;
+    pool.Wait(false);
+
+    bool inOrder = static_cast<int>(order.size()) == taskCount;
+    for (int i = 0; inOrder && i < taskCount; ++i)
+        inOrder = order[i] == i;
+    Check(inOrder, "ThreadPool: tasks from outside the pool did not start in submission order");
+}
+
+/**
+* \brief In the last bound of a parallel optimal search, the tasks after the one with the solution are cancelled
+* instead of being searched in full.
+*/
+void TestOptimalSearchCancellation(const std::string& tableDirectory)
+{
+    OptimalSolver solver(tableDirectory, 4);
+    std::mt19937 random(3);
+    for (int scramble = 0; scramble < 5; ++scramble)
+    {
+        CubeState cube;
+        for (int i = 0; i < 13; ++i)
+            cube.ApplyMove(static_cast<Move>(random() % 18)); // face turns only
+        std::vector<Move> solution;
+        OptimalSolver::SearchStatistics statistics;
+        bool solved = solver.Solve(cube, solution, OptimalSolver::MAX_LENGTH, &statistics);
+        for (Move move : solution)
+            cube.ApplyMove(move);
+        Check(solved && cube.IsSolved(), "OptimalSolver: scramble " + std::to_string(scramble) + " not solved");
+
+        // tasks that were already running when the solution turned up may still finish, but not most of the rest
+        int laterTasks = statistics.taskCount - statistics.bestTask - 1;
+        Check(statistics.bestTask < 0 || statistics.cancelledCount * 2 >= laterTasks,
+            "OptimalSolver: scramble " + std::to_string(scramble) + " cancelled only " + std::to_string(statistics.cancelledCount)
+            + " of the " + std::to_string(laterTasks) + " tasks after the solution");
+    }
+}
+
+int main(int argc, char** argv)
+{
+    std::string tableDirectory = SolverTables::DEFAULT_DIRECTORY;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--tables") == 0 && i + 1 < argc)
+            tableDirectory = argv[++i];
+        else
+        {
+            std::cerr << "Usage: RubixCubeTests [--tables directory]" << std::endl;
+            return 1;
+        }
+    }
+
+    TestThreadPoolOrder();
+    TestOptimalSearchCancellation(tableDirectory);
+
+    std::cerr << (g_failedCount == 0 ? "All checks passed" : std::to_string(g_failedCount) + " checks failed") << std::endl;
+    return g_failedCount;
+}